@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <utils.hpp>
+#include <parameters.hpp>
+#include <agent.hpp>
+#include <planner.hpp>
+#include <planner_api.h>
+
+/** @brief Opaque planner of the C API */
+struct uct_planner {
+    planner pl; ///< Wrapped planner
+    batch_planner batch; ///< Planner of the batches, with the same parameters
+
+    /** @brief Constructor */
+    explicit uct_planner(parameters &sp) : pl(sp), batch(sp) {}
+};
+
+/** @brief Get the message of the last failure of the calling thread */
+std::string & last_error() {
+    static thread_local std::string error;
+    return error;
+}
+
+/**
+ * @brief Guarded call
+ *
+ * Call 'f', any exception being recorded as the last failure. Template method.
+ * @return Return 0 on success and -1 on failure.
+ */
+template <class F>
+int guarded_call(F f) {
+    try {
+        f();
+        return 0;
+    }
+    catch(const std::exception &e) {
+        last_error() = e.what();
+    }
+    catch(...) {
+        last_error() = "unknown exception";
+    }
+    return -1;
+}
+
+extern "C" {
+
+void uct_planner_default_config(uct_planner_config * config) {
+    static const int default_action_space[2] = {-1,1};
+    parameters sp;
+    config->policy_selector = 1;
+    config->budget = sp.BUDGET;
+    config->horizon = sp.HORIZON;
+    config->uct_cst = sp.UCT_CST;
+    config->discount_factor = sp.DISCOUNT_FACTOR;
+    config->epsilon = sp.EPSILON;
+    config->action_space = default_action_space;
+    config->nb_actions = 2;
+    config->init_s = sp.INIT_S;
+    config->model_track_len = sp.MODEL_TRACK_LEN;
+    config->model_stddev = sp.MODEL_STDDEV;
+    config->model_failure_probability = sp.MODEL_FAILURE_PROBABILITY;
+    for(unsigned i=0; i<5; ++i) {
+        config->decision_criteria[i] = (i == 0) ? 1 : 0;
+    }
+    config->state_variance_threshold = .4;
+    config->distance_threshold = 1.;
+    config->outcome_variance_threshold = .0005;
+    config->seed = 0;
+}
+
+uct_planner * uct_planner_create(const uct_planner_config * config) {
+    uct_planner * result = nullptr;
+    guarded_call([&]() {
+        if(config->action_space == nullptr || config->nb_actions == 0) {
+            throw std::invalid_argument("empty action space");
+        }
+        parameters sp;
+        sp.POLICY_SELECTOR = config->policy_selector;
+        sp.BUDGET = config->budget;
+        sp.HORIZON = config->horizon;
+        sp.UCT_CST = config->uct_cst;
+        sp.DISCOUNT_FACTOR = config->discount_factor;
+        sp.EPSILON = config->epsilon;
+        sp.ACTION_SPACE.assign(config->action_space,config->action_space + config->nb_actions);
+        sp.INIT_S = config->init_s;
+        sp.MODEL_TRACK_LEN = config->model_track_len;
+        sp.MODEL_STDDEV = config->model_stddev;
+        sp.MODEL_FAILURE_PROBABILITY = config->model_failure_probability;
+        for(unsigned i=0; i<5; ++i) {
+            sp.DECISION_CRITERIA.push_back(config->decision_criteria[i] != 0);
+        }
+        sp.STATE_VARIANCE_THRESHOLD = config->state_variance_threshold;
+        sp.DISTANCE_THRESHOLD = config->distance_threshold;
+        sp.OUTCOME_VARIANCE_THRESHOLD = config->outcome_variance_threshold;
+        if(config->seed != 0) {
+            set_random_seed(config->seed);
+        }
+        result = new uct_planner(sp);
+    });
+    return result;
+}
+
+uct_planner * uct_planner_create_from_file(const char * cfg_path) {
+    uct_planner * result = nullptr;
+    guarded_call([&]() {
+        parameters sp(cfg_path);
+        if(sp.SEED != 0) {
+            set_random_seed(sp.SEED);
+        }
+        result = new uct_planner(sp);
+    });
+    return result;
+}
+
+int uct_planner_decide(uct_planner * planner, double state, int * action) {
+    return guarded_call([&]() {*action = planner->pl.decide(state);});
+}
+
+int uct_planner_decide_batch(uct_planner * planner, const double * states, int * actions, unsigned nb_states) {
+    return guarded_call([&]() {planner->batch.decide(states,actions,nb_states);});
+}
+
+int uct_planner_observe(uct_planner * planner, double next_state) {
+    return guarded_call([&]() {planner->pl.observe(next_state);});
+}
+
+int uct_planner_reset(uct_planner * planner, double state) {
+    return guarded_call([&]() {planner->pl.reset(state);});
+}
+
+unsigned uct_planner_nb_calls(const uct_planner * planner) {
+    return const_cast<uct_planner *>(planner)->pl.get_nb_calls();
+}
+
+void uct_planner_destroy(uct_planner * planner) {
+    delete planner;
+}
+
+const char * uct_planner_last_error(void) {
+    return last_error().c_str();
+}
+
+}
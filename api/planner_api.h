@@ -0,0 +1,90 @@
+#ifndef PLANNER_API_H_
+#define PLANNER_API_H_
+
+/**
+ * @brief Planner C API
+ *
+ * Stable C interface of the planner (see 'src/planner.hpp'), built as 'libplanner.a' and
+ * 'libplanner.so' by 'make lib'. A planner is created, used and destroyed by the same
+ * thread. The functions returning an int return 0 on success and -1 on failure, the message
+ * of the last failure of the calling thread being given by 'uct_planner_last_error'.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct uct_planner uct_planner; ///< Opaque planner
+
+/**
+ * @brief Planner configuration
+ *
+ * Parameters of the policy and of its model, see 'main.cfg' for their meaning. Initialized
+ * with the default values by 'uct_planner_default_config'.
+ */
+typedef struct uct_planner_config {
+    unsigned policy_selector; ///< 0: vanilla UCT; 1, 2: OLUCT; 3: expectimax; other: epsilon-optimal policy
+    unsigned budget; ///< Number of expanded nodes per tree
+    unsigned horizon; ///< Horizon of the default policy
+    double uct_cst; ///< UCT constant factor
+    double discount_factor; ///< Discount factor
+    double epsilon; ///< Epsilon of the default policy
+    const int * action_space; ///< Actions, 'nb_actions' of them
+    unsigned nb_actions; ///< Number of actions
+    double init_s; ///< Initial state
+    double model_track_len; ///< Model track length (half of the length of the track)
+    double model_stddev; ///< Model noise standard deviation
+    double model_failure_probability; ///< Model failure probability
+    int decision_criteria[5]; ///< Decision criteria of OLUCT, see 'main.cfg'
+    double state_variance_threshold; ///< Threshold of the state distribution variance test
+    double distance_threshold; ///< Threshold of the distance test
+    double outcome_variance_threshold; ///< Threshold of the outcome distribution variance test
+    unsigned long long seed; ///< Seed of the random engine of the calling thread (0: unchanged)
+} uct_planner_config;
+
+/** @brief Fill a configuration with the default values */
+void uct_planner_default_config(uct_planner_config * config);
+
+/** @brief Create a planner from a configuration, return NULL on failure */
+uct_planner * uct_planner_create(const uct_planner_config * config);
+
+/** @brief Create a planner from a configuration file such as 'main.cfg', return NULL on failure */
+uct_planner * uct_planner_create_from_file(const char * cfg_path);
+
+/**
+ * @brief Get the action at the given state, written in 'action'
+ *
+ * The steady-state decisions of UCT and OLUCT do not allocate, unless the speculative
+ * planning or expectimax ('policy_selector = 3') is set (see 'api/test_allocations.cpp').
+ */
+int uct_planner_decide(uct_planner * planner, double state, int * action);
+
+/**
+ * @brief Get the actions of independent states
+ *
+ * Plan each state from scratch with the parameters of the planner, the states being split
+ * across the worker threads; the tree of the planner is not used. May be called from any
+ * thread.
+ */
+int uct_planner_decide_batch(uct_planner * planner, const double * states, int * actions, unsigned nb_states);
+
+/** @brief Observe the state reached after the last decision */
+int uct_planner_observe(uct_planner * planner, double next_state);
+
+/** @brief Discard the tree and start a new episode at the given state */
+int uct_planner_reset(uct_planner * planner, double state);
+
+/** @brief Get the number of calls to the model since the creation */
+unsigned uct_planner_nb_calls(const uct_planner * planner);
+
+/** @brief Destroy a planner, NULL is ignored */
+void uct_planner_destroy(uct_planner * planner);
+
+/** @brief Get the message of the last failure of the calling thread */
+const char * uct_planner_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLANNER_API_H_
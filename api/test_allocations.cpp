@@ -0,0 +1,225 @@
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <planner_api.h>
+
+std::atomic<unsigned long long> nb_allocations(0); ///< Number of calls to the global operator new
+
+void * operator new(std::size_t size) {
+    ++nb_allocations;
+    void * ptr = std::malloc(size == 0 ? 1 : size);
+    if(ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void * ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+/**
+ * @brief Test track
+ *
+ * Dynamics of the 1D track (see 'track.hpp'), only the C API of the library being linked.
+ */
+struct test_track {
+    double track_len; ///< Half of the length of the track
+    double stddev; ///< Noise standard deviation
+    double failure_probability; ///< Probability of the opposite action effect
+    std::mt19937_64 engine; ///< Random engine of the environment
+
+    /** @brief Terminal state test */
+    bool is_terminal(double s) const {
+        return std::fabs(s) >= track_len;
+    }
+
+    /** @brief Sample the next state */
+    double transition(double s, int a) {
+        double noise = (stddev > 0.) ? std::normal_distribution<double>(0.,stddev)(engine) : 0.;
+        if(std::uniform_real_distribution<double>(0.,1.)(engine) < failure_probability) {
+            a = -a;
+        }
+        return s + (double) a + noise;
+    }
+};
+
+/**
+ * @brief Allocation test case
+ *
+ * Planner configuration driven by the test, either through the C configuration or through a
+ * copy of 'main.cfg' with some settings overridden (for the modes the C configuration does
+ * not expose).
+ */
+struct test_case {
+    const char * name; ///< Name of the case
+    unsigned policy_selector; ///< Policy of the planner
+    double stddev; ///< Noise standard deviation of the track and of the model
+    int criterion; ///< Decision criterion of OLUCT (index of 'b0' to 'b4')
+    const char * overrides; ///< Settings of 'main.cfg' overridden by the case, or nullptr
+    bool allocation_free; ///< Whether the steady-state decisions must not allocate
+};
+
+/**
+ * @brief Write a configuration file
+ *
+ * Copy 'main.cfg' and replace the settings assigned in the overrides, one 'name = value;'
+ * per line.
+ * @param {const std::string &} path; path of the written file
+ * @param {const std::string &} overrides; overridden settings
+ * @return Return true if the file was written.
+ */
+bool write_config(const std::string &path, const std::string &overrides) {
+    std::map<std::string,std::string> settings;
+    std::istringstream ov(overrides);
+    std::string line;
+    while(std::getline(ov,line)) {
+        settings[line.substr(0,line.find(' '))] = line;
+    }
+    std::ifstream in("main.cfg");
+    std::ofstream out(path);
+    if(!in || !out) {
+        return false;
+    }
+    while(std::getline(in,line)) {
+        auto it = settings.find(line.substr(0,line.find(' ')));
+        out << ((it != settings.end()) ? it->second : line) << "\n";
+    }
+    return (bool) out;
+}
+
+/**
+ * @brief Create the planner of a test case
+ * @param {const test_case &} tc; test case
+ * @param {uct_planner_config &} config; configuration of the planner, also used by the track
+ * @return Return the planner, or nullptr if the creation failed.
+ */
+uct_planner * create_planner(const test_case &tc, uct_planner_config &config) {
+    uct_planner_default_config(&config);
+    config.policy_selector = tc.policy_selector;
+    config.budget = 200;
+    config.model_stddev = tc.stddev;
+    config.seed = 42;
+    for(unsigned i=0; i<5; ++i) {
+        config.decision_criteria[i] = ((int) i == tc.criterion) ? 1 : 0;
+    }
+    if(tc.overrides == nullptr) {
+        return uct_planner_create(&config);
+    }
+    std::ostringstream overrides;
+    overrides << std::showpoint; // libconfig is strictly typed, the doubles need a decimal point
+    overrides << "policy_selector = " << config.policy_selector << ";\n"
+              << "budget = " << config.budget << ";\n"
+              << "stddev = " << tc.stddev << ";\n"
+              << "model_stddev = " << tc.stddev << ";\n"
+              << "seed = " << config.seed << ";\n";
+    for(unsigned i=0; i<5; ++i) {
+        overrides << "b" << i << " = " << (config.decision_criteria[i] ? "true" : "false") << ";\n";
+    }
+    overrides << tc.overrides;
+    const std::string path = "api_test_exe.cfg";
+    if(!write_config(path,overrides.str())) {
+        std::fprintf(stderr,"cannot write %s from main.cfg\n",path.c_str());
+        return nullptr;
+    }
+    uct_planner * planner = uct_planner_create_from_file(path.c_str());
+    if(planner == nullptr) { // the file is kept for the diagnosis
+        std::fprintf(stderr,"cannot create a planner from %s, overridden settings:\n%s",
+            path.c_str(),overrides.str().c_str());
+        return nullptr;
+    }
+    std::remove(path.c_str());
+    return planner;
+}
+
+/**
+ * @brief Count the allocations of the decisions
+ *
+ * Drive the planner of a test case along episodes of the track and count the heap
+ * allocations made by the decision calls.
+ * @param {const test_case &} tc; test case
+ * @param {unsigned} nb_decisions; number of counted decisions
+ * @return Return the number of allocations, or -1 if the planner failed.
+ */
+long long count_decision_allocations(const test_case &tc, unsigned nb_decisions) {
+    uct_planner_config config;
+    uct_planner * planner = create_planner(tc,config);
+    if(planner == nullptr) {
+        std::fprintf(stderr,"creation failed: %s\n",uct_planner_last_error());
+        return -1;
+    }
+    test_track tr = {config.model_track_len,tc.stddev,config.model_failure_probability,std::mt19937_64(7)};
+    double s = config.init_s;
+    unsigned long long total = 0;
+    for(unsigned i=0; i<nb_decisions; ++i) {
+        if(tr.is_terminal(s)) {
+            s = config.init_s;
+            uct_planner_reset(planner,s);
+        }
+        int action = 0;
+        unsigned long long before = nb_allocations;
+        int status = uct_planner_decide(planner,s,&action);
+        total += nb_allocations - before;
+        if(status != 0) {
+            std::fprintf(stderr,"decision failed: %s\n",uct_planner_last_error());
+            uct_planner_destroy(planner);
+            return -1;
+        }
+        s = tr.transition(s,action);
+        if(uct_planner_observe(planner,s) != 0) {
+            std::fprintf(stderr,"observation failed: %s\n",uct_planner_last_error());
+            uct_planner_destroy(planner);
+            return -1;
+        }
+    }
+    uct_planner_destroy(planner);
+    return (long long) total;
+}
+
+/**
+ * @brief Main function of the allocation test
+ *
+ * Fail if a steady-state decision of an allocation-free mode calls the heap allocator, or if
+ * a planner fails. The modes that allocate are reported only:
+ * - speculation launches an asynchronous task per step;
+ * - expectimax memoizes the values in an 'std::unordered_map' rebuilt at each decision.
+ */
+int main() {
+    const unsigned nb_decisions = 2000;
+    const test_case cases[] = {
+        {"vanilla UCT", 0, 0., 0, nullptr, true},
+        {"vanilla UCT", 0, .2, 0, nullptr, true},
+        {"OLUCT b0", 1, 0., 0, nullptr, true},
+        {"OLUCT b0", 1, .2, 0, nullptr, true},
+        {"OLUCT b1 (multimodality)", 1, .2, 1, nullptr, true},
+        {"OLUCT b2 (state variance)", 1, .2, 2, nullptr, true},
+        {"OLUCT b3 (distance)", 1, .2, 3, nullptr, true},
+        {"OLUCT b4 (outcome variance)", 1, .2, 4, nullptr, true},
+        {"OLUCT b2 warm start", 1, .2, 2, "warm_start = true;\n", true},
+        {"OLUCT speculation", 1, .2, 0, "speculative_planning = true;\n", false},
+        {"expectimax", 3, 0., 0, "expectimax_depth = 6;\n", false}
+    };
+    int status = 0;
+    for(const auto &tc : cases) {
+        long long n = count_decision_allocations(tc,nb_decisions);
+        std::printf("%s, stddev %g: %lld allocation(s) in %u decisions%s\n",
+            tc.name,tc.stddev,n,nb_decisions,tc.allocation_free ? "" : " (not allocation-free)");
+        if(n < 0 || (tc.allocation_free && n != 0)) {
+            status = 1;
+        }
+    }
+    std::printf(status == 0 ? "OK\n" : "FAILED\n");
+    return status;
+}
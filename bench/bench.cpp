@@ -0,0 +1,594 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <utils.hpp>
+#include <parameters.hpp>
+#include <agent.hpp>
+#include <track.hpp>
+#include <thread_pool.hpp>
+#include <planner.hpp>
+
+constexpr unsigned long long BENCH_SEED = 42; ///< Seed of every benchmark
+
+/**
+ * @brief Benchmark result
+ *
+ * Measured value of a single benchmark.
+ */
+struct bench_result {
+    std::string name; ///< Name of the benchmark, unique
+    double value; ///< Measured value
+    std::string unit; ///< Unit of the value
+    bool higher_is_better; ///< True for rates, false for sizes and durations
+};
+
+/**
+ * @brief Benchmark statistics
+ *
+ * Best value of a benchmark over the repetitions of the suite, and relative spread of the
+ * repetitions, used as the noise band of the timings.
+ */
+struct bench_stats {
+    bench_result best; ///< Best repetition
+    double spread; ///< (worst - best) / best over the repetitions, 0 for a single repetition
+};
+
+/**
+ * @brief Is timing
+ *
+ * The rates ('.../s') depend on the load of the machine, the other values (model calls,
+ * nodes, bytes) are deterministic counters given the seed.
+ * @param {const bench_result &} r; benchmark result
+ * @return Return true if the value is a timing.
+ */
+bool is_timing(const bench_result &r) {
+    return r.unit.size() >= 2 && r.unit.compare(r.unit.size() - 2,2,"/s") == 0;
+}
+
+/**
+ * @brief Legacy model
+ *
+ * Copy of the concrete model used before the 'generative_model' interface was introduced.
+ * Kept as a reference to check that the interface costs nothing.
+ */
+struct legacy_model {
+    double model_track_length;
+    double model_stddev;
+    double model_failure_probability;
+    unsigned nb_calls;
+
+    legacy_model(double tl, double sd, double fp) :
+        model_track_length(tl), model_stddev(sd), model_failure_probability(fp), nb_calls(0) {}
+
+    double transition_model(double s, int a) {
+        nb_calls++;
+        double action_effect = (double) a;
+        if(is_less_than(uniform_double(0.,1.),model_failure_probability)) {
+            action_effect *= (-1.);
+        }
+        return s + action_effect + normal_double(0.,model_stddev);
+    }
+
+    double reward_model(double s, int a, double s_p) {
+        (void) a; (void) s_p;
+        return is_less_than(std::abs(s),model_track_length) ? 0. : 1.;
+    }
+
+    bool is_terminal(double s) {
+        return !is_less_than(std::fabs(s),model_track_length);
+    }
+};
+
+/**
+ * @brief Elapsed time
+ *
+ * @return Return the elapsed time in seconds since the given time point.
+ */
+double seconds_since(const std::chrono::steady_clock::time_point &start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Benchmark parameters
+ *
+ * Parameters shared by the benchmarks: a short noisy track so that an episode lasts a few
+ * tens of decisions.
+ * @param {unsigned} policy_selector; policy selector
+ * @return Return the parameters.
+ */
+parameters bench_parameters(unsigned policy_selector) {
+    parameters sp(
+        10., // track_len
+        .1, // stddev
+        .1, // failure_probability
+        0., // init_s
+        std::vector<int>{-1,1},
+        policy_selector,
+        100, // budget
+        10, // horizon
+        .7, // uct_cst
+        .9, // discount_factor
+        0., // epsilon
+        10., // model_track_len
+        .1, // model_stddev
+        .1 // model_failure_probability
+    );
+    sp.DECISION_CRITERIA = std::vector<bool>{true,false,false,false,false};
+    sp.STATE_VARIANCE_THRESHOLD = .4;
+    sp.DISTANCE_THRESHOLD = 1.;
+    sp.OUTCOME_VARIANCE_THRESHOLD = .0005;
+    return sp;
+}
+
+/**
+ * @brief Make agent
+ *
+ * @return Return an agent at the initial state built with the given parameters.
+ */
+agent make_agent(parameters &sp) {
+    policy_parameters p(sp);
+    model m(sp.MODEL_TRACK_LEN, sp.MODEL_STDDEV, sp.MODEL_FAILURE_PROBABILITY);
+    return agent(sp.INIT_S,p,m);
+}
+
+/**
+ * @brief Measure a rate
+ *
+ * Call 'f' which performs 'nb_ops' operations, 'nb_repeats' times, and keep the fastest
+ * repetition. Template method.
+ * @return Return the number of operations per second.
+ */
+template <class F>
+double measure_rate(F f, unsigned nb_ops, unsigned nb_repeats = 3) {
+    double best = 9e99;
+    for(unsigned r=0; r<nb_repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best,seconds_since(start));
+    }
+    return ((double) nb_ops) / best;
+}
+
+/**
+ * @brief Rollout steps
+ *
+ * Run rollouts of the given model (transition, reward and terminal test at each step).
+ * Template method.
+ * @return Return a checksum preventing the loop from being optimized away.
+ */
+template <class M>
+double rollout_steps(M &m, unsigned nb_steps) {
+    double s = 0., checksum = 0.;
+    int a = 1;
+    for(unsigned i=0; i<nb_steps; ++i) {
+        double s_p = m.transition_model(s,a);
+        checksum += m.reward_model(s,a,s_p);
+        s = m.is_terminal(s_p) ? 0. : s_p;
+        a = -a;
+    }
+    return checksum;
+}
+
+/**
+ * @brief Model micro-benchmarks
+ *
+ * Steps per second of the legacy concrete model and of the 'model' implementation of the
+ * 'generative_model' interface, single and batch entry points.
+ */
+void bench_model(std::vector<bench_result> &results, unsigned n) {
+    set_random_seed(BENCH_SEED);
+    volatile double sink = 0.;
+    legacy_model lm(25.,.1,.1);
+    model m(25.,.1,.1);
+    results.push_back({"transition_model_legacy", measure_rate([&]() {sink = rollout_steps(lm,n);},n), "steps/s", true});
+    results.push_back({"transition_model", measure_rate([&]() {sink = rollout_steps(m,n);},n), "steps/s", true});
+    std::vector<double> s(n,0.), s_p(n,0.);
+    std::vector<int> a(n,1);
+    results.push_back({"transition_model_batch", measure_rate([&]() {m.transition_model_batch(s.data(),a.data(),s_p.data(),n);},n), "steps/s", true});
+    (void) sink;
+}
+
+/**
+ * @brief Tree micro-benchmarks
+ *
+ * UCT child selection, node creation and move to child rates.
+ */
+void bench_tree(std::vector<bench_result> &results, unsigned n) {
+    set_random_seed(BENCH_SEED);
+    parameters sp = bench_parameters(0);
+    agent ag = make_agent(sp);
+    ag.build_uct_tree(sp.INIT_S);
+    volatile node * sink = nullptr;
+    results.push_back({"uct_child", measure_rate([&]() {
+        for(unsigned i=0; i<n; ++i) {sink = ag.uct_child(ag.p.root_node);}
+    },n), "selections/s", true});
+    (void) sink;
+
+    node root(0.,sp.ACTION_SPACE);
+    results.push_back({"create_child", measure_rate([&]() {
+        for(unsigned i=0; i<n/2; ++i) {
+            root.create_child(root.get_next_expansion_action(),1.);
+            root.create_child(root.get_next_expansion_action(),-1.);
+            root.clear_node();
+        }
+    },2*(n/2)), "nodes/s", true});
+
+    unsigned nb_moves = 0;
+    double moves_time = 0.;
+    sp.BUDGET = 1000;
+    agent ag_bis = make_agent(sp);
+    while(nb_moves < n / 100) {
+        ag_bis.build_uct_tree(sp.INIT_S);
+        while(ag_bis.p.root_node.is_fully_expanded() && nb_moves < n / 100) {
+            auto start = std::chrono::steady_clock::now();
+            ag_bis.p.root_node.move_to_child(0,sp.INIT_S);
+            moves_time += seconds_since(start);
+            ++nb_moves;
+        }
+    }
+    results.push_back({"move_to_child", ((double) nb_moves) / moves_time, "moves/s", true});
+}
+
+/**
+ * @brief Decision criteria micro-benchmarks
+ *
+ * Evaluate each decision criterion on the sub-tree kept after an OLUCT decision.
+ */
+void bench_decision_criteria(std::vector<bench_result> &results, unsigned n) {
+    set_random_seed(BENCH_SEED);
+    parameters sp = bench_parameters(1);
+    sp.BUDGET = 1000;
+    agent ag = make_agent(sp);
+    ag.take_action();
+    volatile bool sink = false;
+    n /= 10;
+    results.push_back({"state_multimodality_test", measure_rate([&]() {
+        for(unsigned i=0; i<n; ++i) {sink = ag.state_multimodality_test(ag.s);}
+    },n), "tests/s", true});
+    results.push_back({"state_distribution_variance_test", measure_rate([&]() {
+        for(unsigned i=0; i<n; ++i) {sink = ag.state_distribution_variance_test();}
+    },n), "tests/s", true});
+    results.push_back({"distance_to_state_distribution_mean_test", measure_rate([&]() {
+        for(unsigned i=0; i<n; ++i) {sink = ag.distance_to_state_distribution_mean_test(ag.s);}
+    },n), "tests/s", true});
+    results.push_back({"outcome_distribution_variance_test", measure_rate([&]() {
+        for(unsigned i=0; i<n; ++i) {sink = ag.outcome_distribution_variance_test();}
+    },n), "tests/s", true});
+    (void) sink;
+}
+
+/**
+ * @brief Tree building benchmark
+ *
+ * Build vanilla UCT trees of increasing budgets with a one step horizon so that the node
+ * creation dominates, and report the node creation rate and the memory footprint of the
+ * tree. The first build warms up the node pool and the sample arena, the second one is
+ * measured.
+ */
+void bench_tree_build(std::vector<bench_result> &results, unsigned max_budget) {
+    set_random_seed(BENCH_SEED);
+    for(unsigned budget=100; budget<=max_budget; budget*=10) {
+        parameters sp;
+        sp.TRACK_LEN = 1e3;
+        sp.MODEL_TRACK_LEN = 1e3;
+        sp.BUDGET = budget;
+        sp.HORIZON = 1;
+        agent ag = make_agent(sp);
+        ag.build_uct_tree(0.);
+        auto start = std::chrono::steady_clock::now();
+        ag.build_uct_tree(0.);
+        double elapsed = seconds_since(start);
+        unsigned nb_nodes = 0;
+        size_t bytes = 0;
+        ag.p.root_node.add_tree_size(nb_nodes,bytes);
+        std::string suffix = "_budget_" + std::to_string(budget);
+        results.push_back({"tree_build" + suffix, ((double) nb_nodes) / elapsed, "nodes/s", true});
+        results.push_back({"tree_bytes_per_node" + suffix, ((double) bytes) / ((double) nb_nodes), "bytes", false});
+        ag.p.root_node.clear_node();
+    }
+}
+
+/**
+ * @brief Policy macro-benchmarks
+ *
+ * Decisions and episodes per second of vanilla UCT, OLUCT and the epsilon-optimal policy
+ * on the benchmark track.
+ */
+void bench_policies(std::vector<bench_result> &results, unsigned nb_episodes) {
+    std::vector<std::pair<std::string,unsigned>> policies = {
+        {"uct",0}, {"oluct",1}, {"epsilon_optimal",99} // any unused selector is epsilon-optimal
+    };
+    for(auto &pol : policies) {
+        set_random_seed(BENCH_SEED);
+        parameters sp = bench_parameters(pol.second);
+        unsigned nb_decisions = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(unsigned i=0; i<nb_episodes; ++i) {
+            track tr(sp.TRACK_LEN, sp.STDDEV, sp.FAILURE_PROBABILITY);
+            agent ag = make_agent(sp);
+            while(!tr.is_terminal(ag.s)) {
+                ag.take_action();
+                ag.s = tr.transition(ag.s, ag.a);
+                ++nb_decisions;
+            }
+            ag.p.root_node.clear_node();
+        }
+        double elapsed = seconds_since(start);
+        results.push_back({pol.first + "_decisions", ((double) nb_decisions) / elapsed, "decisions/s", true});
+        results.push_back({pol.first + "_episodes", ((double) nb_episodes) / elapsed, "episodes/s", true});
+    }
+}
+
+/**
+ * @brief Symmetry folding benchmark
+ *
+ * Decisions per second and model calls per decision on the noise-free benchmark track
+ * (discrete track and model) without then with the symmetry folding: vanilla UCT and OLUCT,
+ * whose trees built at the state 0 are shared with their mirror, vanilla UCT with a decision
+ * cache shared by the episodes, and expectimax.
+ */
+void bench_symmetry(std::vector<bench_result> &results, unsigned nb_episodes) {
+    std::vector<std::pair<std::string,unsigned>> policies = {{"uct_noise_free",0}, {"oluct_noise_free",1}, {"uct_cache",0}, {"expectimax",3}};
+    for(auto &pol : policies) {
+        for(bool folding : {false,true}) {
+            set_random_seed(BENCH_SEED);
+            parameters sp = bench_parameters(pol.second);
+            sp.STDDEV = sp.MODEL_STDDEV = 0.;
+            sp.DISCRETE_FAST_PATH = true;
+            sp.SYMMETRY_FOLDING = folding;
+            decision_cache decisions(sp.DECISION_CACHE_QUANTUM,sp.DECISION_CACHE_SIZE,sp.DECISION_CACHE_MIN_VISITS);
+            unsigned nb_decisions = 0;
+            unsigned long long nb_calls = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned i=0; i<nb_episodes; ++i) {
+                discrete_track tr(sp.TRACK_LEN, sp.FAILURE_PROBABILITY);
+                basic_agent<discrete_model> ag(sp.INIT_S,policy_parameters(sp),discrete_model(sp.MODEL_TRACK_LEN,sp.MODEL_FAILURE_PROBABILITY));
+                ag.decisions = (pol.first == "uct_cache") ? &decisions : nullptr;
+                while(!tr.is_terminal(ag.s)) {
+                    ag.take_action();
+                    ag.s = tr.transition(ag.s, ag.a);
+                    ++nb_decisions;
+                }
+                nb_calls += ag.get_nb_calls();
+                ag.p.root_node.clear_node();
+            }
+            double elapsed = seconds_since(start);
+            std::string name = pol.first + (folding ? "_folded" : "");
+            results.push_back({name + "_decisions", ((double) nb_decisions) / elapsed, "decisions/s", true});
+            results.push_back({name + "_calls", ((double) nb_calls) / ((double) nb_decisions), "calls/decision", false});
+        }
+    }
+}
+
+/**
+ * @brief Batch planning benchmark
+ *
+ * Decisions per second for independent states planned from scratch with vanilla UCT:
+ * one pool task and one agent per state, then the batch planner.
+ */
+void bench_batch(std::vector<bench_result> &results, unsigned nb_states) {
+    set_random_seed(BENCH_SEED);
+    parameters sp = bench_parameters(0);
+    std::vector<double> states(nb_states);
+    for(auto &s : states) {
+        s = uniform_double(-sp.TRACK_LEN,sp.TRACK_LEN);
+    }
+    std::vector<int> actions(nb_states);
+    double per_state_rate = measure_rate([&]() {
+        std::vector<std::future<void>> done;
+        for(unsigned i=0; i<nb_states; ++i) {
+            done.push_back(global_thread_pool().submit([&sp,&states,&actions,i]() {
+                agent ag = make_agent(sp);
+                ag.s = states[i];
+                ag.take_action();
+                actions[i] = ag.a;
+                ag.p.root_node.clear_node();
+            }));
+        }
+        for(auto &d : done) {
+            d.get();
+        }
+    },nb_states);
+    batch_planner bp(sp);
+    double batch_rate = measure_rate([&]() {
+        bp.decide(states.data(),actions.data(),nb_states);
+    },nb_states);
+    results.push_back({"per_state_task_decisions", per_state_rate, "decisions/s", true});
+    results.push_back({"batch_decisions", batch_rate, "decisions/s", true});
+}
+
+/**
+ * @brief Summarize the repetitions
+ *
+ * Keep the best value of each benchmark over the repetitions of the suite, i.e. the least
+ * disturbed by the other loads of the machine, and the relative spread of the repetitions.
+ * @param {const std::vector<std::vector<bench_result>> &} repetitions; results of each run
+ * of the suite, in the same order
+ * @return Return the statistics of each benchmark.
+ */
+std::vector<bench_stats> summarize_repetitions(const std::vector<std::vector<bench_result>> &repetitions) {
+    std::vector<bench_stats> stats;
+    for(unsigned i=0; i<repetitions.front().size(); ++i) {
+        bench_result best = repetitions.front()[i];
+        double worst = best.value;
+        for(auto &rep : repetitions) {
+            double v = rep[i].value;
+            best.value = best.higher_is_better ? std::max(best.value,v) : std::min(best.value,v);
+            worst = best.higher_is_better ? std::min(worst,v) : std::max(worst,v);
+        }
+        double spread = (best.value != 0.) ? std::fabs(worst - best.value) / std::fabs(best.value) : 0.;
+        stats.push_back({best, spread});
+    }
+    return stats;
+}
+
+/**
+ * @brief Write results
+ *
+ * Write the results as JSON.
+ */
+void write_results(const std::vector<bench_stats> &results, std::ostream &os) {
+    os << "{\n  \"seed\": " << BENCH_SEED << ",\n  \"benchmarks\": [\n";
+    for(unsigned i=0; i<results.size(); ++i) {
+        const bench_result &r = results[i].best;
+        os << "    {\"name\": \"" << r.name << "\", ";
+        os << "\"value\": " << r.value << ", ";
+        os << "\"spread\": " << results[i].spread << ", ";
+        os << "\"unit\": \"" << r.unit << "\", ";
+        os << "\"higher_is_better\": " << (r.higher_is_better ? "true" : "false") << "}";
+        os << ((i + 1 < results.size()) ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+}
+
+/**
+ * @brief Read results
+ *
+ * Read the results written by 'write_results'. Only this format is supported: one
+ * benchmark per line. The spread is 0 if the file does not give it.
+ */
+std::vector<bench_stats> read_results(const std::string &path) {
+    std::ifstream infile(path);
+    if(!infile) {
+        throw std::runtime_error("cannot open baseline file " + path);
+    }
+    std::vector<bench_stats> results;
+    std::string line;
+    auto field = [](const std::string &l, const std::string &key) {
+        size_t pos = l.find("\"" + key + "\": ");
+        if(pos == std::string::npos) {return std::string();}
+        pos += key.size() + 4;
+        size_t end = l.find_first_of(",}",pos);
+        std::string v = l.substr(pos,end - pos);
+        v.erase(std::remove(v.begin(),v.end(),'"'),v.end());
+        return v;
+    };
+    while(std::getline(infile,line)) {
+        std::string name = field(line,"name");
+        if(name.empty()) {continue;}
+        bench_result r = {name, atof(field(line,"value").c_str()), field(line,"unit"), field(line,"higher_is_better") == "true"};
+        results.push_back({r, atof(field(line,"spread").c_str())});
+    }
+    return results;
+}
+
+/**
+ * @brief Compare results
+ *
+ * Compare the results to a baseline and flag the benchmarks whose relative degradation
+ * exceeds their tolerance. A timing is flagged beyond 'tolerance' plus the spreads of the
+ * repetitions of both runs; a deterministic counter beyond 'counter_tolerance'.
+ * @return Return the number of regressions.
+ */
+unsigned compare_results(
+    const std::vector<bench_stats> &results,
+    const std::vector<bench_stats> &baseline,
+    double tolerance,
+    double counter_tolerance)
+{
+    unsigned nb_regressions = 0;
+    for(auto &st : results) {
+        const bench_result &r = st.best;
+        auto it = std::find_if(baseline.begin(),baseline.end(),
+            [&r](const bench_stats &b) {return b.best.name == r.name;});
+        if(it == baseline.end() || it->best.value == 0.) {
+            std::cerr << "  NEW        " << r.name << "\n";
+            continue;
+        }
+        double change = (r.value - it->best.value) / it->best.value;
+        double degradation = r.higher_is_better ? -change : change;
+        double limit = is_timing(r) ? tolerance + st.spread + it->spread : counter_tolerance;
+        bool regression = degradation > limit;
+        nb_regressions += regression;
+        std::cerr << (regression ? "  REGRESSION " : "  ok         ") << r.name << ": ";
+        std::cerr << it->best.value << " -> " << r.value << " " << r.unit;
+        std::cerr << " (" << (change >= 0. ? "+" : "") << 100. * change << "%, limit ";
+        std::cerr << 100. * limit << "%)\n";
+    }
+    return nb_regressions;
+}
+
+/**
+ * @brief Benchmark main function
+ *
+ * Options:
+ * --quick; smaller problem sizes
+ * --output <path>; write the JSON results to the file instead of the standard output
+ * --compare <path>; compare to a baseline JSON file, exit with 1 in case of regression
+ * --tolerance <x>; relative degradation of a timing flagged as a regression, on top of the
+ * spread of the repetitions (default .1)
+ * --counter-tolerance <x>; relative degradation of a deterministic counter flagged as a
+ * regression (default .001, the rounding of the JSON values)
+ * --repetitions <k>; number of runs of the suite, the best run of each benchmark is kept
+ * (default 3)
+ */
+int main(int argc, char* argv[]) {
+    try {
+        bool quick = false;
+        std::string output_path, baseline_path;
+        double tolerance = .1;
+        double counter_tolerance = .001;
+        unsigned nb_repetitions = 3;
+        for(int i=1; i<argc; ++i) {
+            std::string arg = argv[i];
+            if(arg == "--quick") {
+                quick = true;
+            } else if(arg == "--output" && i + 1 < argc) {
+                output_path = argv[++i];
+            } else if(arg == "--compare" && i + 1 < argc) {
+                baseline_path = argv[++i];
+            } else if(arg == "--tolerance" && i + 1 < argc) {
+                tolerance = atof(argv[++i]);
+            } else if(arg == "--counter-tolerance" && i + 1 < argc) {
+                counter_tolerance = atof(argv[++i]);
+            } else if(arg == "--repetitions" && i + 1 < argc) {
+                nb_repetitions = std::max(1,atoi(argv[++i]));
+            } else {
+                throw wrong_nb_input_argument_exception();
+            }
+        }
+        unsigned n = quick ? 100000 : 1000000;
+        std::vector<std::vector<bench_result>> repetitions(nb_repetitions);
+        for(auto &rep : repetitions) {
+            bench_model(rep,n);
+            bench_tree(rep,n);
+            bench_decision_criteria(rep,n);
+            bench_tree_build(rep,quick ? 10000 : 100000);
+            bench_policies(rep,quick ? 10 : 100);
+            bench_batch(rep,quick ? 2000 : 20000);
+            bench_symmetry(rep,quick ? 20 : 200);
+        }
+        std::vector<bench_stats> results = summarize_repetitions(repetitions);
+
+        if(output_path.empty()) {
+            write_results(results,std::cout);
+        } else {
+            std::ofstream outfile(output_path);
+            write_results(results,outfile);
+            std::cerr << "Results written at '" << output_path << "'\n";
+        }
+        if(!baseline_path.empty()) {
+            std::cerr << "Comparison with '" << baseline_path << "' (tolerance " << tolerance;
+            std::cerr << " plus the spreads for the timings, " << counter_tolerance << " for the counters):\n";
+            if(compare_results(results,read_results(baseline_path),tolerance,counter_tolerance) > 0) {
+                return 1;
+            }
+        }
+    }
+    catch(const std::exception &e) {
+        std::cerr<<"Error in main(): standard exception caught: "<<e.what()<<std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -1,9 +1,11 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <random>
@@ -16,79 +18,548 @@
 #include <display.hpp>
 #include <test.hpp>
 #include <save.hpp>
+#include <timing.hpp>
+#include <aggregate.hpp>
+#include <thread_pool.hpp>
+#include <journal.hpp>
+#include <sharding.hpp>
+#include <opening.hpp>
 
 /**
  * @brief Simulate a single episode
  *
  * Run a single 1D track simulation given its parameters.
+ * The computational cost is the CPU time of the calling thread plus that of the background
+ * speculation of the agent, the wall-clock time of the episode and the latency quantiles of
+ * the decisions are saved as well.
  * @warning The values should be saved in the same order as in the 'get_saved_values_names'
  * method (edit 22/09/2017).
- * @param {track &} tr; environment
- * @param {agent &} ag; agent
+ * Template method, instantiated for the general and the discrete tracks and agents.
+ * @param {T &} tr; environment
+ * @param {A &} ag; agent
  * @param {bool} prnt; if true, print some informations during the simulation
  * @param {bool} bckp; if true, save some informations in the end of the simulation
  * @param {std::vector<std::vector<double>>} bckp_vector; backup vector into which each
  * simulation records its backed up values
  */
+template <class T, class A>
 void simulate_episode(
-    track &tr,
-    agent &ag,
+    T &tr,
+    A &ag,
     bool prnt,
     bool bckp,
     std::vector<std::vector<double>> &bckp_vector)
 {
-	std::clock_t c_start = std::clock();
+    TRACE_SCOPE("episode");
+    latency_histogram decision_latencies;
+    unsigned nb_decisions = 0;
+    stopwatch episode_watch;
 	while(!tr.is_terminal(ag.s)) {
+        double decision_start = wall_clock_ms();
 		ag.take_action(); // take action based on current state (attribute of the agent)
+        decision_latencies.record(1000. * (wall_clock_ms() - decision_start));
+        ++nb_decisions;
 		if(prnt) {print(tr,ag);}
+        ag.start_speculation(); // no-op unless the speculative planning is enabled
 		ag.s = tr.transition(ag.s, ag.a); // get next state
+        ag.stop_speculation();
 	}
-    std::clock_t c_end = std::clock();
+    double cpu_time_ms = episode_watch.cpu_ms() + ag.speculation_cpu_ms;
+    double wall_time_ms = episode_watch.wall_ms();
     if(prnt) {print(tr,ag);}
     if(bckp) { // warning in comments refers to this section
-        double time_elapsed_ms = 1000. * (c_end-c_start) / CLOCKS_PER_SEC;
         std::vector<double> simulation_backup = { //
             (double) tr.time,
-            time_elapsed_ms,
-            (double) ag.get_nb_calls()
+            cpu_time_ms,
+            (double) ag.get_nb_calls(),
+            wall_time_ms,
+            decision_latencies.quantile(.5),
+            decision_latencies.quantile(.99),
+            decision_latencies.max,
+            (double) ag.get_peak_nb_nodes(),
+            (double) ag.get_peak_tree_bytes(),
+            (double) local_node_pool().nb_misses,
+            (double) local_node_pool().nb_recycled,
+            (double) nb_decisions
         };
+        if(ag.decisions != nullptr) {
+            simulation_backup.push_back((double) ag.nb_cache_hits);
+            simulation_backup.push_back((double) ag.nb_cache_misses);
+        }
+#ifdef UCT_PROFILE
+        for(auto &v : ag.prof.get_backup()) {
+            simulation_backup.push_back(v);
+        }
+#endif
+        if(ag.p.perf_counters) {
+            for(auto &v : ag.build_counts.get_backup()) {
+                simulation_backup.push_back(v);
+            }
+            for(auto &v : ag.rollout_counts.get_backup()) {
+                simulation_backup.push_back(v);
+            }
+        }
         bckp_vector.push_back(simulation_backup);
     }
 }
 
+/**
+ * @brief Configuration caches
+ *
+ * Caches shared by the episodes of a configuration, possibly run by several threads.
+ */
+struct configuration_caches {
+    std::unique_ptr<opening_cache> opening; ///< Opening tree, nullptr if not enabled
+    std::unique_ptr<decision_cache> decisions; ///< Decision cache, nullptr if not enabled
+};
+
+/**
+ * @brief Run a single episode on a given track and model
+ *
+ * Template method, see 'run_episode'.
+ * @param {T &} tr; environment
+ * @param {M} m; model of the agent
+ * @param {parameters &} sp; parameters of the configuration
+ * @param {bool} prnt; if true, print some informations during the simulation
+ * @param {unsigned long long} seed; seed of the episode, 0 if not seeded
+ * @param {configuration_caches *} caches; caches of the configuration, nullptr if none
+ * @return Return the saved values of the episode.
+ */
+template <class T, class M>
+std::vector<double> run_episode_on(
+    T &tr,
+    M m,
+    parameters &sp,
+    bool prnt,
+    unsigned long long seed,
+    configuration_caches * caches)
+{
+    tr.step_duration_ms = sp.STEP_DURATION_MS;
+    policy_parameters p(sp);
+    basic_agent<M> ag(sp.INIT_S,p,m);
+    if(seed != 0) {
+        ag.speculation_seed = mix_seed(seed,string_hash("speculation"));
+    }
+    std::vector<std::vector<double>> bckp_vector;
+    local_node_pool().reset_counters();
+    if(caches != nullptr && caches->opening) {
+        ag.load_opening(caches->opening->tree);
+    }
+    if(caches != nullptr) {
+        ag.decisions = caches->decisions.get();
+    }
+    simulate_episode(tr,ag,prnt,true,bckp_vector);
+    ag.p.root_node.clear_node(); // recycle the tree for the next episode
+    return bckp_vector.back();
+}
+
+/**
+ * @brief Run a single episode
+ *
+ * Create the environment and the agent of a configuration then simulate a single episode.
+ * The noise-free configurations run on the discrete track and model (see
+ * 'parameters::is_discrete'). May be called concurrently by several threads.
+ * @param {parameters &} sp; parameters of the configuration
+ * @param {bool} prnt; if true, print some informations during the simulation
+ * @param {unsigned long long} seed; seed of the episode, the random engine of the thread is
+ * left as is if 0
+ * @param {configuration_caches *} caches; caches of the configuration, nullptr if none
+ * @return Return the saved values of the episode.
+ */
+std::vector<double> run_episode(
+    parameters &sp,
+    bool prnt,
+    unsigned long long seed = 0,
+    configuration_caches * caches = nullptr)
+{
+    if(seed != 0) {
+        set_random_seed(seed);
+    }
+    if(sp.is_discrete()) {
+        discrete_track tr(sp.TRACK_LEN, sp.FAILURE_PROBABILITY);
+        discrete_model m(sp.MODEL_TRACK_LEN, sp.MODEL_FAILURE_PROBABILITY);
+        return run_episode_on(tr,m,sp,prnt,seed,caches);
+    }
+    track tr(sp.TRACK_LEN, sp.STDDEV, sp.FAILURE_PROBABILITY);
+    model m(sp.MODEL_TRACK_LEN, sp.MODEL_STDDEV, sp.MODEL_FAILURE_PROBABILITY);
+    return run_episode_on(tr,m,sp,prnt,seed,caches);
+}
+
+/**
+ * @brief Make the configuration caches
+ *
+ * Build the opening tree and create the empty decision cache, if enabled.
+ * @param {parameters &} sp; parameters of the configuration
+ * @param {const std::string &} outpth; output path of the configuration, used to derive the
+ * seed of the opening
+ * @return Return the caches of the configuration.
+ */
+std::unique_ptr<configuration_caches> make_caches(parameters &sp, const std::string &outpth) {
+    std::unique_ptr<configuration_caches> caches(new configuration_caches());
+    if(opening_cache::is_enabled(sp)) {
+        unsigned long long seed = 0;
+        if(sp.SEED != 0) {
+            seed = mix_seed(mix_seed(sp.SEED,string_hash(outpth)),string_hash("opening"));
+        }
+        caches->opening.reset(new opening_cache(sp,seed));
+    }
+    if(sp.DECISION_CACHE) {
+        caches->decisions.reset(new decision_cache(
+            sp.DECISION_CACHE_QUANTUM,
+            sp.DECISION_CACHE_SIZE,
+            sp.DECISION_CACHE_MIN_VISITS
+        ));
+    }
+    return caches;
+}
+
+/**
+ * @brief Get the precision names
+ *
+ * @return Return the names of the achieved precision values of the sequential stopping mode.
+ */
+std::vector<std::string> get_precision_names() {
+    return std::vector<std::string>{"confidence", "score_ci_width", "computational_cost_ci_width"};
+}
+
+/**
+ * @brief Precision reached
+ *
+ * Test the stopping rule of the sequential stopping mode.
+ * @param {const parameters &} sp; parameters of the configuration
+ * @param {const running_stats &} score_stats; statistics of the scores
+ * @param {const running_stats &} cost_stats; statistics of the computational costs
+ * @return Return true if the confidence intervals are narrower than their targets.
+ */
+bool is_precision_reached(
+    const parameters &sp,
+    const running_stats &score_stats,
+    const running_stats &cost_stats)
+{
+    if(confidence_interval_width(score_stats,sp.CONFIDENCE) > sp.CI_TARGET_WIDTH) {
+        return false;
+    }
+    return sp.CI_COST_TARGET_WIDTH <= 0.
+        || confidence_interval_width(cost_stats,sp.CONFIDENCE) <= sp.CI_COST_TARGET_WIDTH;
+}
+
 /**
  * @brief Bunch of run with the same parameters
  *
  * Bunch of run with the same parameters.
+ * In aggregation mode (see 'parameters::AGGREGATE'), the saved values of the episodes are
+ * aggregated on-line and a single summary row is saved in the end, with its mergeable state.
+ * In sequential stopping mode (see 'parameters::CI_TARGET_WIDTH'), the number of simulations
+ * is not fixed: the episodes are run in parallel batches on the global thread pool until the
+ * confidence intervals reach their target widths; the achieved precision is saved as well.
+ * Each task of a batch records its episodes in its own statistics, merged after the batch.
+ * With a journal, the completed episodes are journaled batch by batch: a configuration
+ * completed before a restart is skipped and the journaled episodes of an interrupted one are
+ * reused, the stopping tests being made at the same episodes. If 'parameters::SEED' is not 0,
+ * each episode is seeded from the seed, the output path and the episode indice.
+ * The caches of the configuration (opening tree and decision cache) are created once before
+ * the episodes and shared by them.
  * @param {parameters &} sp; parameters used for all the simulations
- * @param {unsigned} nbsim; number of simulations
- * @param {bool} prnt; if true, print some informations during the simulation
+ * @param {unsigned} nbsim; number of simulations, ignored in sequential stopping mode
+ * @param {bool} prnt; if true, print some informations during the simulation (ignored in
+ * sequential stopping mode)
  * @param {bool} bckp; if true, save some informations in the end of the simulation
- * @param {const std::string &} outpth; output saving path is backup
+ * @param {const std::string &} outpth; output saving path is backup, also used as the key
+ * of the configuration in the journal
+ * @param {sweep_journal *} journal; journal of the sweep, nullptr if none
  */
 void run(
     parameters &sp,
     unsigned nbsim,
     bool prnt,
     bool bckp,
-    const std::string &outpth = "data/test.csv")
+    const std::string &outpth = "data/test.csv",
+    sweep_journal * journal = nullptr)
 {
-    std::vector<std::vector<double>> bckp_vector;
-    std::string sep = ",";
+    if(journal != nullptr && journal->is_done(outpth)) {
+        return;
+    }
+    size_t nb_values = get_saved_values_names(sp).size();
+    unsigned long long config_seed = mix_seed(sp.SEED,string_hash(outpth));
+    std::unique_ptr<backup_writer> writer;
+    std::unique_ptr<episode_aggregate> aggregate;
     if(bckp) {
-        initialize_backup(get_saved_values_names(),outpth,sep);
-    }
-    for(unsigned i=0; i<nbsim; ++i) {
-        //std::cout << "Simulation " << i+1 << "/" << nbsim << std::endl;
-        track tr(sp.TRACK_LEN, sp.STDDEV, sp.FAILURE_PROBABILITY);
-        policy_parameters p(sp);
-        model m(sp.MODEL_TRACK_LEN, sp.MODEL_STDDEV, sp.MODEL_FAILURE_PROBABILITY);
-        agent ag(sp.INIT_S,p,m);
-
-        simulate_episode(tr,ag,prnt,bckp,bckp_vector);
+        if(sp.AGGREGATE) {
+            aggregate.reset(new episode_aggregate(nb_values));
+        } else {
+            writer.reset(new backup_writer(outpth,get_saved_values_names(sp),sp.OUTPUT_FORMAT));
+        }
+    }
+    std::unique_ptr<configuration_caches> caches = make_caches(sp,outpth);
+    bool sequential_stopping = sp.CI_TARGET_WIDTH > 0.;
+    running_stats score_stats, cost_stats;
+    std::vector<episode_aggregate> partials; // statistics recorded by each task of a batch
+    if(sequential_stopping) {
+        partials.assign(global_thread_pool().get_nb_threads(),episode_aggregate(nb_values));
+    }
+    unsigned nb_episodes = 0;
+    while(sequential_stopping
+        ? (nb_episodes < sp.MAX_EPISODES && !is_precision_reached(sp,score_stats,cost_stats))
+        : nb_episodes < nbsim)
+    {
+        unsigned batch_size = 1; // episodes run in parallel in sequential stopping mode
+        if(sequential_stopping) {
+            batch_size = std::min(std::max(sp.BATCH_SIZE,1u),sp.MAX_EPISODES - nb_episodes);
+        }
+        std::vector<std::vector<double>> bckp_vector(batch_size);
+        std::vector<bool> is_new(batch_size,true);
+        for(unsigned i=0; i<batch_size; ++i) {
+            const std::vector<double> * saved = nullptr;
+            if(journal != nullptr) {
+                saved = journal->find_episode(outpth,nb_episodes + i,nb_values);
+            }
+            if(saved != nullptr) { // completed before a restart
+                bckp_vector[i] = *saved;
+                is_new[i] = false;
+            }
+        }
+        auto seed_of = [&](unsigned i) {
+            return (sp.SEED != 0) ? mix_seed(config_seed,nb_episodes + i) : 0ULL;
+        };
+        if(sequential_stopping) { // each task records its episodes, the statistics are merged
+            unsigned nb_tasks = std::min(batch_size,(unsigned) partials.size());
+            std::vector<std::future<void>> tasks;
+            for(unsigned k=0; k<nb_tasks; ++k) {
+                episode_aggregate * partial = &partials[k];
+                configuration_caches * c = caches.get();
+                tasks.push_back(global_thread_pool().submit([&,partial,c,k,nb_tasks]() {
+                    partial->reset();
+                    for(unsigned i=k; i<batch_size; i+=nb_tasks) {
+                        if(is_new[i]) {
+                            bckp_vector[i] = run_episode(sp,false,seed_of(i),c);
+                            partial->record(bckp_vector[i]);
+                        }
+                    }
+                }));
+            }
+            for(auto &task : tasks) {
+                task.get();
+            }
+            for(unsigned k=0; k<nb_tasks; ++k) {
+                score_stats.merge(partials[k].columns[0]);
+                cost_stats.merge(partials[k].columns[1]);
+                if(aggregate) {
+                    aggregate->merge(partials[k]);
+                }
+            }
+        } else if(is_new[0]) {
+            //std::cout << "Simulation " << nb_episodes+1 << "/" << nbsim << std::endl;
+            bckp_vector[0] = run_episode(sp,prnt,seed_of(0),caches.get());
+        }
+        for(unsigned i=0; i<batch_size; ++i) {
+            if(journal != nullptr && is_new[i]) {
+                journal->record_episode(outpth,nb_episodes + i,bckp_vector[i]);
+            }
+        }
+        if(journal != nullptr) {
+            journal->flush();
+        }
+        for(unsigned i=0; i<batch_size; ++i) {
+            const std::vector<double> &row = bckp_vector[i];
+            if(!sequential_stopping || !is_new[i]) { // not recorded by a task
+                score_stats.record(row[0]);
+                cost_stats.record(row[1]);
+                if(aggregate) {
+                    aggregate->record(row);
+                }
+            }
+            if(writer) { // rows are streamed to the writer as the batches end
+                writer->write(row);
+            }
+        }
+        nb_episodes += batch_size;
     }
     if(bckp) {
-        save_matrix(bckp_vector,outpth,sep,std::ofstream::app);
+        std::vector<double> precision = {
+            sp.CONFIDENCE,
+            confidence_interval_width(score_stats,sp.CONFIDENCE),
+            confidence_interval_width(cost_stats,sp.CONFIDENCE)
+        };
+        if(aggregate) {
+            std::vector<std::string> names = get_summary_names(get_saved_values_names(sp));
+            std::vector<double> summary = aggregate->get_summary();
+            if(sequential_stopping) {
+                for(unsigned i=0; i<precision.size(); ++i) {
+                    names.push_back(get_precision_names()[i]);
+                    summary.push_back(precision[i]);
+                }
+            }
+            backup_writer summary_writer(outpth,names,sp.OUTPUT_FORMAT);
+            summary_writer.write(summary);
+            summary_writer.close();
+            save_aggregate_state(*aggregate,get_saved_values_names(sp),get_aggregate_state_path(outpth));
+        } else if(sequential_stopping) {
+            std::vector<std::string> names = {"nb_episodes", "score_mean", "computational_cost_mean"};
+            std::vector<double> summary = {(double) nb_episodes, score_stats.mean, cost_stats.mean};
+            for(unsigned i=0; i<precision.size(); ++i) {
+                names.push_back(get_precision_names()[i]);
+                summary.push_back(precision[i]);
+            }
+            std::string path = outpth.substr(0,outpth.find_last_of('.')) + "_precision.csv";
+            backup_writer precision_writer(path,names,sp.OUTPUT_FORMAT);
+            precision_writer.write(summary);
+            precision_writer.close();
+        }
+    }
+    if(writer) {
+        writer->close(); // the backup file is complete before the configuration is journaled
+    }
+    if(journal != nullptr) {
+        journal->record_done(outpth);
+    }
+}
+
+/**
+ * @brief Save rows
+ *
+ * Save the rows of a configuration in a backup file, or their summary in aggregation mode.
+ * @param {parameters &} sp; parameters of the configuration
+ * @param {const std::vector<std::vector<double>> &} rows; saved values of the episodes
+ * @param {const std::string &} outpth; output saving path
+ */
+void save_rows(
+    parameters &sp,
+    const std::vector<std::vector<double>> &rows,
+    const std::string &outpth)
+{
+    std::vector<std::string> names = get_saved_values_names(sp);
+    if(sp.AGGREGATE) {
+        episode_aggregate aggregate(names.size());
+        for(auto &row : rows) {
+            aggregate.record(row);
+        }
+        backup_writer writer(outpth,get_summary_names(names),sp.OUTPUT_FORMAT);
+        writer.write(aggregate.get_summary());
+        writer.close();
+        save_aggregate_state(aggregate,names,get_aggregate_state_path(outpth));
+    } else {
+        backup_writer writer(outpth,names,sp.OUTPUT_FORMAT);
+        for(auto &row : rows) {
+            writer.write(row);
+        }
+        writer.close();
+    }
+}
+
+/**
+ * @brief Merge aggregate states
+ *
+ * Merge the mergeable states saved next to the summaries of several runs of a configuration,
+ * e.g. by the shards of a sweep, then save the merged summary and its state.
+ * @param {const std::string &} outpth; output path of the merged summary
+ * @param {const std::vector<std::string> &} state_paths; paths of the merged states
+ * @param {const std::string &} format; output format of the summary, "csv" or "bin"
+ */
+void merge_aggregate_states(
+    const std::string &outpth,
+    const std::vector<std::string> &state_paths,
+    const std::string &format)
+{
+    std::vector<std::string> names;
+    std::unique_ptr<episode_aggregate> merged;
+    for(auto &path : state_paths) {
+        std::vector<std::string> state_names;
+        episode_aggregate state = load_aggregate_state(path,state_names);
+        if(!merged) {
+            names = state_names;
+            merged.reset(new episode_aggregate(state));
+        } else if(state_names != names) {
+            throw std::runtime_error(path + ": the saved values differ from the first state");
+        } else {
+            merged->merge(state);
+        }
+    }
+    if(!merged) {
+        throw std::runtime_error("no state to merge");
+    }
+    backup_writer writer(outpth,get_summary_names(names),format);
+    writer.write(merged->get_summary());
+    writer.close();
+    save_aggregate_state(*merged,names,get_aggregate_state_path(outpth));
+}
+
+/**
+ * @brief Sharded sweep
+ *
+ * Run a sweep in several processes. The jobs are the (configuration, episode) pairs, indexed
+ * configuration by configuration; this process runs the jobs of indice 'shard' modulo
+ * 'nb_shards', split between 'nb_workers' forked workers pinned to the NUMA nodes. The workers
+ * write the saved values into a shared mapping, then the parent saves each configuration. An
+ * episode is seeded as in 'run', hence a sharded sweep reproduces a single process one if
+ * 'parameters::SEED' is not 0. Otherwise, the episodes are seeded from a nonce of the worker
+ * process, the shard and the job, so that no two workers or shards replay the same stream.
+ * In aggregation mode, each shard saves the mergeable state of its summary, see
+ * 'merge_aggregate_states'.
+ * @param {std::vector<std::pair<parameters, std::string>> &} sweep; parameters and output
+ * path of each configuration
+ * @param {unsigned} nbsim; number of simulations per configuration
+ * @param {unsigned} shard; shard run by this process
+ * @param {unsigned} nb_shards; number of shards
+ * @param {unsigned} nb_workers; number of worker processes, the jobs are run by this process
+ * if 0
+ */
+void run_sharded(
+    std::vector<std::pair<parameters, std::string>> &sweep,
+    unsigned nbsim,
+    unsigned shard,
+    unsigned nb_shards,
+    unsigned nb_workers)
+{
+    std::vector<size_t> jobs; // jobs of the shard
+    for(size_t j=shard; j<sweep.size() * nbsim; j+=nb_shards) {
+        jobs.push_back(j);
+    }
+    size_t stride = 0;
+    for(auto &conf : sweep) {
+        stride = std::max(stride,get_saved_values_names(conf.first).size());
+    }
+    shared_results results(jobs.size(),stride);
+    unsigned nb_processes = std::max(nb_workers,1u);
+    auto work = [&](unsigned w) {
+        unsigned long long nonce = mix_seed(process_nonce(),shard); // seeds of the unseeded sweeps
+        std::vector<std::unique_ptr<configuration_caches>> caches(sweep.size()); // created when first needed
+        for(size_t k=w; k<jobs.size(); k+=nb_processes) {
+            std::pair<parameters, std::string> &conf = sweep[jobs[k] / nbsim];
+            std::unique_ptr<configuration_caches> &conf_caches = caches[jobs[k] / nbsim];
+            if(!conf_caches) {
+                conf_caches = make_caches(conf.first,conf.second);
+            }
+            unsigned indice = (unsigned) (jobs[k] % nbsim);
+            unsigned long long seed = mix_seed(nonce,jobs[k]);
+            if(conf.first.SEED != 0) {
+                seed = mix_seed(mix_seed(conf.first.SEED,string_hash(conf.second)),indice);
+            }
+            results.store(k,run_episode(conf.first,false,seed,conf_caches.get()));
+        }
+    };
+    if(nb_workers == 0) {
+        work(0);
+    } else if(fork_workers(nb_workers,work) > 0) {
+        throw std::runtime_error("a sweep worker failed");
+    }
+    for(size_t c=0; c<sweep.size(); ++c) {
+        size_t nb_values = get_saved_values_names(sweep[c].first).size();
+        std::vector<std::vector<double>> rows;
+        for(size_t k=0; k<jobs.size(); ++k) {
+            if(jobs[k] / nbsim == c) {
+                if(!results.is_done(k)) {
+                    throw std::runtime_error("a sweep job is missing");
+                }
+                rows.push_back(results.load(k,nb_values));
+            }
+        }
+        std::string path = sweep[c].second;
+        if(nb_shards > 1) {
+            size_t ext = path.find_last_of('.');
+            path = path.substr(0,ext) + "_shard" + std::to_string(shard) + "of"
+                + std::to_string(nb_shards) + path.substr(ext);
+        }
+        save_rows(sweep[c].first,rows,path);
     }
 }
 
@@ -97,9 +568,13 @@ void run(
  *
  * Run a bunch of run with different parameters. The latter are set in this function, you
  * can modify it as you wish.
+ * The configurations are run one after the other by 'run', or by 'run_sharded' if several
+ * worker processes or shards are used.
  * @param {const unsigned &} nbsim; number of simulations
+ * @param {unsigned} shard; shard run by this process
+ * @param {unsigned} nb_shards; number of shards
  */
-void test(unsigned nbsim) {
+void test(unsigned nbsim, unsigned shard = 0, unsigned nb_shards = 1) {
     //std::vector<double> fp_range = {.0, .05, .1, .15, .2, .25, .3, .35, .4, .45, .5, .55, .6, .65, .7, .75, .8, .85, .9, .95, 1.};
     std::vector<double> fp_range = {.0, .05, .1, .15, .2, .25, .3, .35, .4, .45, .5};
 	//std::vector<double> fp_range = {.0};
@@ -113,12 +588,13 @@ void test(unsigned nbsim) {
             sp.MODEL_FAILURE_PROBABILITY = fp;
             std::string path = get_backup_path(sp);
             std::cout << "Output: " << path << std::endl;
-            run(sp,nbsim,false,true,path);
+            sweep.push_back(std::make_pair(sp,path));
         }
     }
     */
     std::string root_path = "data/long_";
     parameters sp("main.cfg");
+    std::vector<std::pair<parameters, std::string>> sweep;
     sp.POLICY_SELECTOR = 1;
     // OLUCT
     //for(unsigned i=0; i<5; ++i) { // for every decision criterion
@@ -142,7 +618,7 @@ void test(unsigned nbsim) {
                 std::cout << sp.DECISION_CRITERIA[j] << " ";
             }
             std::cout << std::endl;
-            run(sp,nbsim,false,true,path);
+            sweep.push_back(std::make_pair(sp,path));
         }
     }
     // UCT
@@ -156,9 +632,20 @@ void test(unsigned nbsim) {
         path += ".csv";
         std::cout << "Output: " << path << std::endl;
         std::cout << "  fp  : " << fp << std::endl;
-        run(sp,nbsim,false,true,path);
+        sweep.push_back(std::make_pair(sp,path));
     }
 	*/
+    if(sp.NB_WORKERS > 0 || nb_shards > 1) {
+        run_sharded(sweep,nbsim,shard,nb_shards,sp.NB_WORKERS);
+    } else {
+        std::unique_ptr<sweep_journal> journal;
+        if(!sp.JOURNAL_PATH.empty()) {
+            journal.reset(new sweep_journal(sp.JOURNAL_PATH));
+        }
+        for(auto &conf : sweep) {
+            run(conf.first,nbsim,false,true,conf.second,journal.get());
+        }
+    }
 }
 
 /**
@@ -168,10 +655,21 @@ void test(unsigned nbsim) {
  * Example: ./exe 1000 will produce 1000 simulations performed with the parameters initialized
  * by the user in the function.
  * Default is 100 simulations, set if nothing is specified.
+ * Use second argument 'i/n' to run only the shard 'i' of 'n' of the simulations, e.g. on
+ * the i-th of n machines: ./exe 1000 0/4
+ * In aggregation mode, the summaries of the shards are merged from their saved states with:
+ * ./exe merge data/x.csv data/x_shard0of4_state.bin ... data/x_shard3of4_state.bin
  */
 int main(int argc, char* argv[]) {
     try {
-        srand(time(NULL));
+        set_random_seed(process_nonce()); // distinct for the shards started at the same time
+        if(argc > 2 && std::string(argv[1]) == "merge") {
+            parameters sp("main.cfg");
+            std::vector<std::string> state_paths(argv + 3,argv + argc);
+            std::cout << "Merge " << state_paths.size() << " state(s) into " << argv[2] << "\n";
+            merge_aggregate_states(argv[2],state_paths,sp.OUTPUT_FORMAT);
+            return 0;
+        }
         switch(argc) {
             case 1: { //default
                 std::string cfg_path = "main.cfg";
@@ -186,10 +684,24 @@ int main(int argc, char* argv[]) {
                 test(atoi(argv[1]));
                 break;
             }
+            case 3: { // number of simulation and shard given
+                unsigned shard = 0, nb_shards = 0;
+                char slash = 0;
+                if(std::sscanf(argv[2],"%u%c%u",&shard,&slash,&nb_shards) != 3
+                    || slash != '/' || shard >= nb_shards) {
+                    throw wrong_shard_argument_exception();
+                }
+                std::cout << "Run shard " << argv[2] << " of " << argv[1] << " simulation(s)\n";
+                test(atoi(argv[1]),shard,nb_shards);
+                break;
+            }
             default: {
                 throw wrong_nb_input_argument_exception();
             }
         }
+#ifdef UCT_TRACE
+        write_chrome_trace("data/trace.json");
+#endif
     }
     catch(const std::exception &e) {
         std::cerr<<"Error in main(): standard exception caught: "<<e.what()<<std::endl;
@@ -0,0 +1,57 @@
+"""
+Reader of the binary columnar result format written by 'src/columnar.hpp'.
+
+Each column is memory-mapped with numpy, hence loading a result file does not parse any
+text. 'load_results' returns a dictionary {column name: numpy array} for either format, the
+columns of a '.bin' file being the memory maps themselves (no copy).
+
+edit: 18/10/2026
+"""
+
+import os
+import struct
+import numpy as np
+import pandas as pd
+
+MAGIC = b"1DTRCOL\0"
+ALIGNMENT = 64
+TYPES = {0: np.dtype('<f8')}
+
+def load_columnar(path):
+    """
+    Load a columnar result file as a dictionary {column name: numpy memmap}.
+    """
+    with open(path, 'rb') as f:
+        magic = f.read(8)
+        if magic != MAGIC:
+            raise ValueError(path + " is not a columnar result file")
+        version, ncols, nrows = struct.unpack('<IIQ', f.read(16))
+        if version != 1:
+            raise ValueError(path + ": unsupported version " + str(version))
+        columns = []
+        for _ in range(ncols):
+            (name_len,) = struct.unpack('<I', f.read(4))
+            name = f.read(name_len).decode('utf-8')
+            (col_type,) = struct.unpack('<B', f.read(1))
+            columns.append((name, TYPES[col_type]))
+        offset = f.tell()
+    offset += (-offset) % ALIGNMENT
+    data = {}
+    for name, dtype in columns:
+        if nrows > 0:
+            data[name] = np.memmap(path, dtype=dtype, mode='r', offset=offset, shape=(nrows,))
+        else:
+            data[name] = np.empty(0, dtype=dtype)
+        offset += nrows * dtype.itemsize
+    return data
+
+def load_results(path, sep=','):
+    """
+    Load a result file as a dictionary {column name: numpy array}. If 'path' is a '.csv'
+    file that does not exist, the '.bin' file with the same name is loaded instead.
+    """
+    root, ext = os.path.splitext(path)
+    if ext == '.bin' or (not os.path.exists(path) and os.path.exists(root + '.bin')):
+        return load_columnar(root + '.bin')
+    data = pd.read_csv(path, sep=sep)
+    return {name: data[name].to_numpy() for name in data.columns}
@@ -11,6 +11,7 @@ import matplotlib.pyplot as plt
 import pandas as pd
 import numpy as np
 import sys
+from columnar import load_results
 
 BLUE = '#333399';
 ORNG = '#ff6600';
@@ -35,7 +36,7 @@ def extract(repo, pth1, fp_rng, pth2, take_log):
 	castd = []
 	for fp in fp_rng:
 		path =	 repo + pth1 + fp + pth2 + fp + ".csv"
-		data = pd.read_csv(path,sep = ',')
+		data = load_results(path)
 		lo = data["score"]
 		cp = data["computational_cost"]
 		ca = data["nb_calls"]
@@ -44,11 +45,11 @@ def extract(repo, pth1, fp_rng, pth2, take_log):
 			cp = np.log(cp)
 			ca = np.log(ca)
 		lomns.append(lo.mean())
-		lostd.append(lo.std())
+		lostd.append(lo.std(ddof=1))
 		cpmns.append(cp.mean())
-		cpstd.append(cp.std())
+		cpstd.append(cp.std(ddof=1))
 		camns.append(ca.mean())
-		castd.append(ca.std())
+		castd.append(ca.std(ddof=1))
 	return [lomns, lostd, cpmns, cpstd, camns, castd]
 
 # Variables --------------------------------------------------------------------
@@ -13,6 +13,7 @@ import matplotlib.pyplot as plt
 import pandas as pd
 import numpy as np
 import sys
+from columnar import load_results
 import matplotlib
 
 # Use Type 1 fonts
@@ -64,16 +65,16 @@ def extract(path, failure_probability_range):
 	castd = []
 	for fp in failure_probability_range:
 		p =	 path + "_fp" + fp + ".csv"
-		data = pd.read_csv(p,sep = ',')
+		data = load_results(p)
 		lo = data["score"]
 		cp = data["computational_cost"]
 		ca = data["nb_calls"]
 		lomns.append(lo.mean())
-		lostd.append(lo.std())
+		lostd.append(lo.std(ddof=1))
 		cpmns.append(cp.mean())
-		cpstd.append(cp.std())
+		cpstd.append(cp.std(ddof=1))
 		camns.append(ca.mean())
-		castd.append(ca.std())
+		castd.append(ca.std(ddof=1))
 	return [lomns, lostd, cpmns, cpstd, camns, castd]
 
 def plot(path, args, color, mrk, fcc, lw, ls, uct_lo_mea):
@@ -10,6 +10,7 @@ import matplotlib.pyplot as plt
 import pandas as pd
 import numpy as np
 import sys
+from columnar import load_results
 
 plt.close('all')
 BLUE = '#333399';
@@ -21,12 +22,12 @@ fp = "00" # failure probability
 path1 = repo + "0_2_00_" + fp + "_20_10_2_09_00_2_00_" + fp + ".csv" # Vanilla UCT
 path2 = repo + "1_2_00_" + fp + "_20_10_2_09_00_2_00_" + fp + ".csv" # OLUCT
 
-d1 = pd.read_csv(path1,sep = ',')
+d1 = load_results(path1)
 scr1 = d1["score"]
 cpu1 = d1["computational_cost"]
 calls1 = d1["nb_calls"]
 
-d2 = pd.read_csv(path2,sep = ',')
+d2 = load_results(path2)
 scr2 = d2["score"]
 cpu2 = d2["computational_cost"]
 calls2 = d2["nb_calls"]
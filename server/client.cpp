@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <utils.hpp>
+#include <parameters.hpp>
+#include <track.hpp>
+#include <exceptions.hpp>
+#include <timing.hpp>
+#include <planner_protocol.hpp>
+
+/**
+ * @brief Planner connection
+ *
+ * Blocking connection of a client to the planner service.
+ */
+struct planner_connection {
+    int fd; ///< Socket
+    uint64_t next_id; ///< Id of the next request
+
+    /** @brief Constructor, connect to the service */
+    explicit planner_connection(const std::string &socket_path) : next_id(0) {
+        sockaddr_un addr;
+        std::memset(&addr,0,sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path,socket_path.c_str(),sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX,SOCK_STREAM,0);
+        if(fd < 0 || connect(fd,(sockaddr *) &addr,sizeof(addr)) < 0) {
+            throw std::runtime_error(std::string("connect: ") + std::strerror(errno));
+        }
+    }
+
+    /** @brief Destructor */
+    ~planner_connection() {
+        close(fd);
+    }
+
+    planner_connection(const planner_connection &) = delete;
+    planner_connection & operator=(const planner_connection &) = delete;
+
+    /**
+     * @brief Call
+     *
+     * Send a request and wait for its response.
+     * @param {uint16_t} type; request type
+     * @param {double} state; state sent with the request
+     * @return Return the response.
+     */
+    planner_response call(uint16_t type, double state) {
+        planner_request req;
+        req.type = type;
+        req.id = next_id++;
+        req.state = state;
+        unsigned char request_frame[PLANNER_REQUEST_SIZE];
+        encode_request(req,request_frame);
+        if(send(fd,request_frame,sizeof(request_frame),MSG_NOSIGNAL) != (ssize_t) sizeof(request_frame)) {
+            throw std::runtime_error("send failed");
+        }
+        unsigned char response_frame[PLANNER_RESPONSE_SIZE];
+        size_t received = 0;
+        while(received < sizeof(response_frame)) {
+            ssize_t n = recv(fd,response_frame + received,sizeof(response_frame) - received,0);
+            if(n <= 0) {
+                throw std::runtime_error("connection closed by the service");
+            }
+            received += (size_t) n;
+        }
+        planner_response res;
+        if(!decode_response(response_frame,res) || res.id != req.id || res.status != PLANNER_OK) {
+            throw std::runtime_error("bad response");
+        }
+        return res;
+    }
+};
+
+/**
+ * @brief Client load
+ *
+ * Simulate episodes on the track, the actions being asked to the service. Called by each
+ * client thread.
+ * @param {parameters &} sp; parameters of the simulated track
+ * @param {const std::string &} socket_path; socket of the service
+ * @param {unsigned} nb_requests; number of decisions asked by the client
+ * @param {latency_histogram &} latencies; round-trip latencies in microseconds
+ * @param {unsigned &} nb_reused; number of decisions answered with a reused tree
+ */
+void client_load(
+    parameters &sp,
+    const std::string &socket_path,
+    unsigned nb_requests,
+    latency_histogram &latencies,
+    unsigned &nb_reused)
+{
+    planner_connection connection(socket_path);
+    track tr(sp.TRACK_LEN,sp.STDDEV,sp.FAILURE_PROBABILITY);
+    double s = sp.INIT_S;
+    connection.call(PLANNER_RESET,s);
+    for(unsigned i=0; i<nb_requests; ++i) {
+        if(tr.is_terminal(s)) { // new episode
+            s = sp.INIT_S;
+            connection.call(PLANNER_RESET,s);
+        }
+        double start = wall_clock_ms();
+        planner_response res = connection.call(PLANNER_DECIDE,s);
+        latencies.record(1000. * (wall_clock_ms() - start));
+        nb_reused += (res.values[2] > .5) ? 1 : 0;
+        s = tr.transition(s,(int) res.action);
+    }
+}
+
+/**
+ * @brief Main function of the load generator
+ *
+ * Run concurrent clients asking the service for actions, then print the client-side
+ * throughput and latencies and the counters of the service.
+ * Example: ./client_exe [nb_clients] [nb_requests_per_client] [socket_path]
+ */
+int main(int argc, char* argv[]) {
+    try {
+        set_random_seed((unsigned long long) time(NULL));
+        parameters sp("main.cfg");
+        if(argc > 4) {
+            throw wrong_nb_input_argument_exception();
+        }
+        unsigned nb_clients = (argc > 1) ? (unsigned) atoi(argv[1]) : 4;
+        unsigned nb_requests = (argc > 2) ? (unsigned) atoi(argv[2]) : 1000;
+        std::string socket_path = (argc > 3) ? argv[3] : sp.SOCKET_PATH;
+        std::vector<latency_histogram> latencies(nb_clients);
+        std::vector<unsigned> nb_reused(nb_clients,0);
+        std::vector<std::thread> clients;
+        std::mutex error_mtx;
+        std::string error;
+        double start = wall_clock_ms();
+        for(unsigned c=0; c<nb_clients; ++c) {
+            clients.emplace_back([&,c]() {
+                try {
+                    client_load(sp,socket_path,nb_requests,latencies[c],nb_reused[c]);
+                }
+                catch(const std::exception &e) {
+                    std::lock_guard<std::mutex> lock(error_mtx);
+                    error = e.what();
+                }
+            });
+        }
+        for(auto &t : clients) {
+            t.join();
+        }
+        double elapsed_s = (wall_clock_ms() - start) / 1000.;
+        if(!error.empty()) {
+            throw std::runtime_error(error);
+        }
+        latency_histogram total;
+        unsigned total_reused = 0;
+        for(unsigned c=0; c<nb_clients; ++c) {
+            total.merge(latencies[c]);
+            total_reused += nb_reused[c];
+        }
+        std::cout << "clients    : " << nb_clients << "\n";
+        std::cout << "decisions  : " << total.count << "\n";
+        std::cout << "reused     : " << total_reused << "\n";
+        std::cout << "throughput : " << (double) total.count / std::max(elapsed_s,1e-9) << " decisions/s\n";
+        std::cout << "rtt p50    : " << total.quantile(.5) << " us\n";
+        std::cout << "rtt p99    : " << total.quantile(.99) << " us\n";
+        std::cout << "rtt max    : " << total.max << " us\n";
+        planner_connection connection(socket_path);
+        planner_response stats = connection.call(PLANNER_STATS,0.);
+        std::cout << "service    : " << stats.values[0] << " requests in " << stats.values[1];
+        std::cout << " batches, latency p50 " << stats.values[2] << " us, p99 " << stats.values[3] << " us\n";
+    }
+    catch(const std::exception &e) {
+        std::cerr<<"Error in main(): standard exception caught: "<<e.what()<<std::endl;
+        return 1;
+    }
+    catch(...) {
+        std::cerr<<"Error in main(): unknown exception caught"<<std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <utils.hpp>
+#include <parameters.hpp>
+#include <agent.hpp>
+#include <thread_pool.hpp>
+#include <timing.hpp>
+#include <planner_protocol.hpp>
+
+std::atomic<bool> stop_requested(false); ///< Set by SIGINT and SIGTERM
+
+/** @brief Signal handler, request the service to stop */
+void handle_signal(int) {
+    stop_requested = true;
+}
+
+/**
+ * @brief Pending request
+ *
+ * Request decoded by the service and waiting for a worker.
+ */
+struct pending_request {
+    planner_request req; ///< Decoded request
+    double arrival_ms; ///< Wall-clock time at which the request was read
+};
+
+/**
+ * @brief Client session
+ *
+ * State of a connected client: its non-blocking socket, its buffers and its warm agent, whose
+ * tree is kept between the requests so that the OLUCT sub-tree reuse works across calls. The
+ * agent is only used by the worker planning the batch of the session, if any.
+ */
+struct client_session {
+    int fd; ///< Client socket (non-blocking)
+    agent ag; ///< Agent of the client
+    std::string input; ///< Received bytes not yet decoded
+    std::string output; ///< Encoded responses not yet sent
+    std::vector<pending_request> queued; ///< Decoded requests waiting for a batch
+    bool busy; ///< True while a batch holding requests of the session is planned
+    bool closing; ///< True once the client disconnected or sent a malformed frame
+    bool gone; ///< True once the client disconnected, its responses are dropped
+
+    /** @brief Constructor */
+    client_session(int _fd, parameters &sp) :
+        fd(_fd),
+        ag(sp.INIT_S,policy_parameters(sp),model(sp.MODEL_TRACK_LEN,sp.MODEL_STDDEV,sp.MODEL_FAILURE_PROBABILITY)),
+        busy(false),
+        closing(false),
+        gone(false)
+    {}
+
+    /** @brief Destructor, recycle the tree and close the socket */
+    ~client_session() {
+        ag.p.root_node.clear_node();
+        close(fd);
+    }
+
+    client_session(const client_session &) = delete;
+    client_session & operator=(const client_session &) = delete;
+};
+
+/**
+ * @brief Planner batch
+ *
+ * Requests of one or several clients planned by one worker, with their encoded responses.
+ */
+struct planner_batch {
+    std::vector<std::pair<client_session *, pending_request>> requests; ///< Requests in order
+    std::vector<unsigned char> responses; ///< Response frames, in the order of the requests
+};
+
+/**
+ * @brief Set non-blocking
+ *
+ * @param {int} fd; file descriptor
+ */
+void set_non_blocking(int fd) {
+    int flags = fcntl(fd,F_GETFL,0);
+    if(flags < 0 || fcntl(fd,F_SETFL,flags | O_NONBLOCK) < 0) {
+        throw std::runtime_error(std::string("fcntl: ") + std::strerror(errno));
+    }
+}
+
+/**
+ * @brief Planner counters
+ *
+ * Throughput and latency counters of the service, updated by the workers.
+ */
+struct planner_counters {
+    std::atomic<unsigned long long> nb_requests; ///< Number of served requests
+    std::atomic<unsigned long long> nb_batches; ///< Number of planned batches
+    std::mutex mtx; ///< Protects the latency histogram
+    latency_histogram latencies; ///< Service latencies in microseconds
+    double start_ms; ///< Wall-clock time at which the service started
+
+    /** @brief Constructor */
+    planner_counters() : nb_requests(0), nb_batches(0), start_ms(wall_clock_ms()) {}
+
+    /** @brief Record the latencies of a batch */
+    void record(const latency_histogram &batch_latencies) {
+        std::lock_guard<std::mutex> lock(mtx);
+        latencies.merge(batch_latencies);
+        nb_requests += batch_latencies.count;
+        ++nb_batches;
+    }
+
+    /** @brief Print the counters */
+    void print(std::ostream &os) {
+        std::lock_guard<std::mutex> lock(mtx);
+        double elapsed_s = (wall_clock_ms() - start_ms) / 1000.;
+        os << "requests   : " << nb_requests << "\n";
+        os << "batches    : " << nb_batches << "\n";
+        os << "throughput : " << (double) nb_requests / std::max(elapsed_s,1e-9) << " requests/s\n";
+        os << "latency p50: " << latencies.quantile(.5) << " us\n";
+        os << "latency p99: " << latencies.quantile(.99) << " us\n";
+        os << "latency max: " << latencies.max << " us\n";
+    }
+};
+
+/**
+ * @brief Planner server
+ *
+ * Planner service over a Unix domain socket. A single I/O thread polls the non-blocking
+ * sockets: it accepts the clients, decodes their requests and sends the buffered responses,
+ * and never waits for the planning. The decoded requests are grouped by client and packed
+ * into batches of at most 'SERVER_MAX_BATCH' requests, planned by the workers of the global
+ * thread pool. A client has at most one batch in flight, hence its requests are answered in
+ * order; the requests received in the meantime are batched once that batch is done. The
+ * workers hand the finished batches back to the I/O thread and wake it up through a pipe.
+ */
+struct planner_server {
+    parameters &sp; ///< Parameters loaded once at the start of the service
+    std::string socket_path; ///< Path of the listening socket
+    int listen_fd; ///< Listening socket (non-blocking)
+    int wake_fds[2]; ///< Pipe written by the workers when a batch is done
+    std::vector<std::unique_ptr<client_session>> sessions; ///< Connected clients
+    std::mutex finished_mtx; ///< Protects the finished batches
+    std::vector<std::unique_ptr<planner_batch>> finished; ///< Batches planned by the workers
+    unsigned nb_in_flight; ///< Number of submitted batches not handed back yet (I/O thread)
+    planner_counters counters; ///< Counters of the service
+
+    /**
+     * @brief Constructor
+     *
+     * Bind and listen on the socket, an existing socket file being replaced.
+     */
+    planner_server(parameters &_sp, const std::string &_socket_path) :
+        sp(_sp),
+        socket_path(_socket_path),
+        nb_in_flight(0)
+    {
+        sockaddr_un addr;
+        std::memset(&addr,0,sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if(socket_path.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("socket path too long: " + socket_path);
+        }
+        std::strcpy(addr.sun_path,socket_path.c_str());
+        if(pipe(wake_fds) < 0) {
+            throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+        }
+        listen_fd = socket(AF_UNIX,SOCK_STREAM,0);
+        if(listen_fd < 0) {
+            close(wake_fds[0]);
+            close(wake_fds[1]);
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        }
+        unlink(socket_path.c_str());
+        if(bind(listen_fd,(sockaddr *) &addr,sizeof(addr)) < 0 || listen(listen_fd,128) < 0) {
+            close(listen_fd);
+            close(wake_fds[0]);
+            close(wake_fds[1]);
+            throw std::runtime_error(std::string("bind: ") + std::strerror(errno));
+        }
+        set_non_blocking(listen_fd);
+        set_non_blocking(wake_fds[0]);
+        set_non_blocking(wake_fds[1]);
+    }
+
+    /** @brief Destructor, wait for the batches in flight then close the sockets */
+    ~planner_server() {
+        while(nb_in_flight > 0) {
+            pollfd wake = {wake_fds[0], POLLIN, 0};
+            poll(&wake,1,100);
+            collect_finished();
+        }
+        sessions.clear();
+        close(listen_fd);
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+        unlink(socket_path.c_str());
+    }
+
+    /**
+     * @brief Serve
+     *
+     * Poll the sockets, submit the received requests and send the responses until a stop is
+     * requested.
+     */
+    void serve() {
+        std::vector<pollfd> fds;
+        while(!stop_requested) {
+            fds.assign(2 + sessions.size(),pollfd());
+            fds[0].fd = listen_fd;
+            fds[0].events = POLLIN;
+            fds[1].fd = wake_fds[0];
+            fds[1].events = POLLIN;
+            for(unsigned i=0; i<sessions.size(); ++i) {
+                client_session &session = *sessions[i];
+                fds[2 + i].fd = session.fd;
+                fds[2 + i].events = (session.closing ? 0 : POLLIN) | (session.output.empty() ? 0 : POLLOUT);
+            }
+            if(poll(fds.data(),fds.size(),100) < 0) { // signal
+                continue;
+            }
+            for(unsigned i=0; i<sessions.size(); ++i) {
+                short revents = fds[2 + i].revents;
+                if(!sessions[i]->closing && (revents & (POLLIN | POLLHUP | POLLERR))) {
+                    read_requests(*sessions[i]);
+                }
+                if(revents & POLLOUT) {
+                    flush_output(*sessions[i]);
+                }
+            }
+            if(fds[1].revents & POLLIN) {
+                collect_finished();
+            }
+            if(fds[0].revents & POLLIN) {
+                accept_clients();
+            }
+            submit_batches();
+            for(unsigned i=sessions.size(); i-->0;) { // the sessions planned by a worker are kept
+                client_session &session = *sessions[i];
+                if(session.closing && !session.busy && (session.gone || session.output.empty())) {
+                    sessions.erase(sessions.begin() + i);
+                }
+            }
+        }
+    }
+
+    /** @brief Accept the pending clients */
+    void accept_clients() {
+        while(true) {
+            int fd = accept(listen_fd,nullptr,nullptr);
+            if(fd < 0) { // EAGAIN once every pending client is accepted
+                return;
+            }
+            try {
+                set_non_blocking(fd);
+            } catch(const std::runtime_error &) {
+                close(fd);
+                continue;
+            }
+            sessions.emplace_back(new client_session(fd,sp));
+        }
+    }
+
+    /**
+     * @brief Read requests
+     *
+     * Read the available bytes of a client and queue its complete request frames. A frame
+     * with a wrong magic number means that the stream is misaligned: nothing after it is
+     * decoded and the session is closed once its previous requests are answered.
+     * @param {client_session &} session; session of the client
+     */
+    void read_requests(client_session &session) {
+        char buffer[4096];
+        while(true) {
+            ssize_t n = recv(session.fd,buffer,sizeof(buffer),0);
+            if(n > 0) {
+                session.input.append(buffer,(size_t) n);
+            } else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else if(n < 0 && errno == EINTR) {
+                continue;
+            } else { // disconnected or failed, the pending responses are dropped
+                session.closing = session.gone = true;
+                session.output.clear();
+                break;
+            }
+        }
+        double now = wall_clock_ms();
+        size_t offset = 0;
+        for(; !session.closing && offset + PLANNER_REQUEST_SIZE <= session.input.size(); offset += PLANNER_REQUEST_SIZE) {
+            pending_request r;
+            r.arrival_ms = now;
+            if(!decode_request((const unsigned char *) session.input.data() + offset,r.req)) {
+                std::cerr << "Closing a client after a frame with a wrong magic number\n";
+                session.closing = true;
+                break;
+            }
+            session.queued.push_back(r);
+        }
+        session.input.erase(0,offset);
+    }
+
+    /**
+     * @brief Flush output
+     *
+     * Send as many buffered responses as the socket accepts.
+     * @param {client_session &} session; session of the client
+     */
+    void flush_output(client_session &session) {
+        size_t offset = 0;
+        while(offset < session.output.size()) {
+            ssize_t n = send(session.fd,session.output.data() + offset,session.output.size() - offset,MSG_NOSIGNAL);
+            if(n > 0) {
+                offset += (size_t) n;
+            } else if(n < 0 && errno == EINTR) {
+                continue;
+            } else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else { // the client is gone
+                session.closing = session.gone = true;
+                session.output.clear();
+                return;
+            }
+        }
+        session.output.erase(0,offset);
+    }
+
+    /**
+     * @brief Submit batches
+     *
+     * Pack the queued requests of the idle sessions into batches and submit them to the global
+     * thread pool without waiting for them.
+     */
+    void submit_batches() {
+        std::unique_ptr<planner_batch> batch;
+        for(auto &s : sessions) {
+            client_session &session = *s;
+            if(session.busy || session.queued.empty()) {
+                continue;
+            }
+            if(batch && batch->requests.size() + session.queued.size() > std::max(sp.SERVER_MAX_BATCH,1u)) {
+                submit(std::move(batch));
+            }
+            if(!batch) {
+                batch.reset(new planner_batch());
+            }
+            for(auto &r : session.queued) {
+                batch->requests.emplace_back(&session,r);
+            }
+            session.queued.clear();
+            session.busy = true;
+        }
+        if(batch) {
+            submit(std::move(batch));
+        }
+    }
+
+    /** @brief Submit a batch to the global thread pool */
+    void submit(std::unique_ptr<planner_batch> batch) {
+        ++nb_in_flight;
+        planner_batch *b = batch.release();
+        global_thread_pool().submit([this,b]() {
+            std::unique_ptr<planner_batch> owned(b);
+            plan_batch(*owned);
+            {
+                std::lock_guard<std::mutex> lock(finished_mtx);
+                finished.push_back(std::move(owned));
+            }
+            char c = 0;
+            ssize_t n = write(wake_fds[1],&c,1); // a full pipe already wakes up the I/O thread
+            (void) n;
+        });
+    }
+
+    /**
+     * @brief Collect finished batches
+     *
+     * Append the responses of the planned batches to the output of their sessions, which are
+     * idle again, and send them.
+     */
+    void collect_finished() {
+        char buffer[256];
+        while(read(wake_fds[0],buffer,sizeof(buffer)) > 0) {}
+        std::vector<std::unique_ptr<planner_batch>> batches;
+        {
+            std::lock_guard<std::mutex> lock(finished_mtx);
+            batches.swap(finished);
+        }
+        for(auto &b : batches) {
+            for(unsigned i=0; i<b->requests.size(); ++i) {
+                client_session &session = *b->requests[i].first;
+                session.busy = false;
+                if(!session.gone) {
+                    session.output.append((const char *) b->responses.data() + i * PLANNER_RESPONSE_SIZE,PLANNER_RESPONSE_SIZE);
+                }
+            }
+            --nb_in_flight;
+        }
+        for(auto &s : sessions) {
+            if(!s->output.empty()) {
+                flush_output(*s);
+            }
+        }
+    }
+
+    /**
+     * @brief Plan a batch
+     *
+     * Answer the requests of a batch in order. Called by a worker.
+     */
+    void plan_batch(planner_batch &batch) {
+        latency_histogram batch_latencies;
+        batch.responses.resize(batch.requests.size() * PLANNER_RESPONSE_SIZE);
+        for(unsigned i=0; i<batch.requests.size(); ++i) {
+            const pending_request &r = batch.requests[i].second;
+            planner_response res;
+            res.type = r.req.type;
+            res.status = PLANNER_OK;
+            res.id = r.req.id;
+            res.action = 0;
+            std::fill(res.values,res.values + 4,0.);
+            agent &ag = batch.requests[i].first->ag;
+            if(r.req.type == PLANNER_DECIDE) {
+                unsigned nb_calls = ag.get_nb_calls();
+                ag.s = r.req.state;
+                ag.take_action();
+                res.action = ag.a;
+                res.values[1] = (double) ag.p.root_node.get_nb_nodes();
+                res.values[2] = (ag.get_nb_calls() == nb_calls) ? 1. : 0.; // no model call: reused
+            } else if(r.req.type == PLANNER_RESET) {
+                ag.p.root_node.clear_node();
+                ag.s = r.req.state;
+                ag.p.root_node.set_state(r.req.state);
+            } else if(r.req.type == PLANNER_STATS) {
+                std::lock_guard<std::mutex> lock(counters.mtx);
+                res.values[0] = (double) counters.nb_requests;
+                res.values[1] = (double) counters.nb_batches;
+                res.values[2] = counters.latencies.quantile(.5);
+                res.values[3] = counters.latencies.quantile(.99);
+            } else {
+                res.status = PLANNER_BAD_REQUEST;
+            }
+            double latency_us = 1000. * (wall_clock_ms() - r.arrival_ms);
+            if(r.req.type == PLANNER_DECIDE) {
+                res.values[0] = latency_us;
+            }
+            batch_latencies.record(latency_us);
+            encode_response(res,batch.responses.data() + i * PLANNER_RESPONSE_SIZE);
+        }
+        counters.record(batch_latencies);
+    }
+};
+
+/**
+ * @brief Main function of the planner service
+ *
+ * Load the parameters of 'main.cfg' once then answer the requests until SIGINT or SIGTERM.
+ * Example: ./server_exe [socket_path], the default socket path being set in 'main.cfg'.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        set_random_seed((unsigned long long) time(NULL));
+        parameters sp("main.cfg");
+        if(argc > 2) {
+            throw wrong_nb_input_argument_exception();
+        }
+        std::string socket_path = (argc == 2) ? argv[1] : sp.SOCKET_PATH;
+        std::signal(SIGINT,handle_signal);
+        std::signal(SIGTERM,handle_signal);
+        planner_server server(sp,socket_path);
+        std::cout << "Planner listening on '" << socket_path << "' with ";
+        std::cout << global_thread_pool().get_nb_threads() << " worker(s)\n";
+        server.serve();
+        server.counters.print(std::cout);
+    }
+    catch(const std::exception &e) {
+        std::cerr<<"Error in main(): standard exception caught: "<<e.what()<<std::endl;
+        return 1;
+    }
+    catch(...) {
+        std::cerr<<"Error in main(): unknown exception caught"<<std::endl;
+        return 1;
+    }
+}
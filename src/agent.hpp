@@ -1,10 +1,21 @@
 #ifndef AGENT_HPP_
 #define AGENT_HPP_
 
+#include <atomic>
+#include <memory>
+
 #include <node.hpp>
+#include <model.hpp>
 #include <test.hpp>
 #include <exceptions.hpp>
 #include <linear_algebra.hpp>
+#include <profiler.hpp>
+#include <perf_counters.hpp>
+#include <trace.hpp>
+#include <thread_pool.hpp>
+#include <decision_cache.hpp>
+#include <timing.hpp>
+#include <expectimax.hpp>
 
 /**
  * @brief Parameters of the policy
@@ -12,7 +23,7 @@
  * This class is a parameters container.
  */
 struct policy_parameters {
-    unsigned policy_selector; ///< Policy selector (0: vanilla UCT; 1: plain OLUCT; default: epsilon-optimal policy)
+    unsigned policy_selector; ///< Policy selector (0: vanilla UCT; 1: plain OLUCT; 3: expectimax; default: epsilon-optimal policy)
     unsigned budget; ///< Algorithm budget (number of expanded nodes)
     unsigned horizon; ///< Algorithm horizon for the default policy
     unsigned expd_counter; ///< Counter of the number of expanded nodes
@@ -25,6 +36,18 @@ struct policy_parameters {
     double state_variance_threshold; ///< Upper threshold for state distribution vmr test
     double distance_threshold; ///< Upper threshold for state distribution distance test
     double outcome_variance_threshold; ///< Upper threshold for outcome distribution variance test
+    size_t tree_memory_cap; ///< Memory cap of the tree in bytes (0: no cap)
+    unsigned history_keep; ///< Number of samples kept per node when the histories are compacted
+    bool perf_counters; ///< If true, hardware counters are collected around the tree building
+    bool speculative_planning; ///< If true, OLUCT grows its tree while the environment steps
+    unsigned speculation_budget; ///< Maximum number of background expansions per step (0: the budget)
+    bool warm_start; ///< If true, an OLUCT rebuild is seeded with the values of the rejected tree
+    double warm_start_confidence; ///< Fraction of the visits of the rejected tree kept as virtual visits
+    unsigned expectimax_depth; ///< Depth of the expectimax search with enumerated outcomes
+    unsigned sparse_sampling_depth; ///< Depth of the expectimax search with sampled outcomes
+    unsigned sparse_sampling_width; ///< Number of sampled outcomes per action of the sparse sampling
+    unsigned expectimax_threads; ///< Number of threads of the expectimax search (1: sequential, 0: hardware threads)
+    bool symmetry_folding; ///< If true, the mirrored states are folded (mirror symmetric models only)
 
     /**
      * @brief Constructor
@@ -50,7 +73,19 @@ struct policy_parameters {
         discount_factor(_discount_factor),
         epsilon(_epsilon),
         action_space(_action_space),
-        root_node(initial_state,action_space)
+        root_node(initial_state,action_space),
+        tree_memory_cap(0),
+        history_keep(8),
+        perf_counters(false),
+        speculative_planning(false),
+        speculation_budget(0),
+        warm_start(false),
+        warm_start_confidence(.5),
+        expectimax_depth(10),
+        sparse_sampling_depth(2),
+        sparse_sampling_width(4),
+        expectimax_threads(1),
+        symmetry_folding(false)
     {
         expd_counter = 0;
     }
@@ -72,7 +107,19 @@ struct policy_parameters {
         root_node(sp.INIT_S,action_space),
         state_variance_threshold(sp.STATE_VARIANCE_THRESHOLD),
         distance_threshold(sp.DISTANCE_THRESHOLD),
-        outcome_variance_threshold(sp.OUTCOME_VARIANCE_THRESHOLD)
+        outcome_variance_threshold(sp.OUTCOME_VARIANCE_THRESHOLD),
+        tree_memory_cap(1024 * (size_t) sp.TREE_MEMORY_CAP),
+        history_keep(sp.HISTORY_KEEP),
+        perf_counters(sp.PERF_COUNTERS),
+        speculative_planning(sp.SPECULATIVE_PLANNING),
+        speculation_budget(sp.SPECULATION_BUDGET),
+        warm_start(sp.WARM_START),
+        warm_start_confidence(sp.WARM_START_CONFIDENCE),
+        expectimax_depth(sp.EXPECTIMAX_DEPTH),
+        sparse_sampling_depth(sp.SPARSE_SAMPLING_DEPTH),
+        sparse_sampling_width(sp.SPARSE_SAMPLING_WIDTH),
+        expectimax_threads(sp.EXPECTIMAX_THREADS),
+        symmetry_folding(sp.SYMMETRY_FOLDING)
     {
         expd_counter = 0;
         decision_criteria_selector = sp.DECISION_CRITERIA;
@@ -80,91 +127,99 @@ struct policy_parameters {
 };
 
 /**
- * @brief Model of the environment
+ * @brief Speculation task
  *
- * Class including the methods able to simulate the states transitions of the environment
- * and the reward function. The accuracy of the model is set with the simulation parameters.
+ * Background growth of the tree of an agent, see 'basic_agent::start_speculation'.
  */
-struct model {
-    double model_track_length; ///< Model length of the track (half of the length)
-    double model_stddev; ///< Model noise standard deviation
-    double model_failure_probability; ///< Probability with chich the oposite action effect is applied in the model (randomness of the transition function)
-    unsigned nb_calls; ///< Tracked number of calls to the model
+struct speculation_task {
+    std::atomic<bool> stop; ///< Set to stop the background growth
+    std::future<void> done; ///< Ready once the background growth is over
+    double cpu_ms; ///< CPU time of the background growth in milliseconds, set once done
 
     /** @brief Constructor */
-    model(
-        double _model_track_length,
-        double _model_stddev,
-        double _model_failure_probability) :
-        model_track_length(_model_track_length),
-        model_stddev(_model_stddev),
-        model_failure_probability(_model_failure_probability)
-    {
-        nb_calls = 0;
-    }
-
-    /**
-     * @brief Transition model
-     *
-     * Simulate a state transition wrt the models parameters.
-     * @param {double} s; state
-     * @param {int} a; action
-     * @return Return the resulting state
-     */
-    double transition_model(double s, int a) {
-        nb_calls++;
-        double action_effect = (double) a;
-        if(is_less_than(uniform_double(0.,1.),model_failure_probability)) {
-            action_effect *= (-1.);
-        }
-        return s + action_effect + normal_double(0.,model_stddev);
-    }
-
-    /**
-     * @brief Reward model
-     *
-     * Reward model of the transition (s,a,s_p)
-     * @param {double} s; state
-     * @param {int} a; action
-     * @param {double} s_p; next state
-     * @return Return the resulting reward
-     */
-    double reward_model(double s, int a, double s_p) {
-        (void) a; (void) s_p; //default
-        return is_less_than(std::abs(s),model_track_length) ? 0. : 1.;
-    }
+    speculation_task() : stop(false), cpu_ms(0.) {}
+};
 
-    /**
-     * @brief Terminal state test
-     *
-     * Test if the state is terminal.
-     * @param {double} s; tested state
-     * @return Return 'true' if terminal
-     */
-    bool is_terminal(double s) {
-        return !is_less_than(std::fabs(s),model_track_length);
-    }
+/**
+ * @brief Action prior
+ *
+ * Value estimate of an action kept from a rejected tree, see 'basic_agent::collect_priors'.
+ */
+struct action_prior {
+    int action; ///< Action
+    double value; ///< Estimated value of the action
+    unsigned nb_virtual_visits; ///< Number of virtual visits carrying the value
 };
 
 /**
  * @brief Agent struct
  *
  * Agent including its policy, model of the environment and parameters.
+ * Template class, the model 'M' should implement the 'generative_model<M>' interface
+ * (see 'model.hpp').
  */
-struct agent {
+template <class M>
+struct basic_agent {
     double s; ///< Current state: value on the track.
     int a; ///< Current action in the action space defined by the parameters.
     policy_parameters p; ///< Policy parameters
-    model m; ///< Model of the environment
+    M m; ///< Model of the environment
+    unsigned peak_nb_nodes; ///< Peak number of nodes of the tree during the episode
+    size_t peak_tree_bytes; ///< Peak memory footprint of the tree during the episode
+    phase_profiler prof; ///< Profiler of the UCT phases (only used if 'UCT_PROFILE' is defined)
+    perf_counts build_counts; ///< Hardware counts of the tree building (if 'p.perf_counters')
+    perf_counts rollout_counts; ///< Hardware counts of the default policy (if 'p.perf_counters')
+    std::vector<double> scores; ///< Scratch buffer of the children scores, capacity kept
+    std::vector<double> modes_values; ///< Scratch buffer of the state multimodality test
+    std::vector<unsigned> modes_counters; ///< Scratch buffer of the state multimodality test
+    std::shared_ptr<speculation_task> speculation; ///< Running background growth of the tree, if any
+    unsigned long long speculation_seed; ///< Base seed of the background growths (0: not reproducible)
+    unsigned nb_speculations; ///< Number of started background growths
+    double speculation_cpu_ms; ///< CPU time of the finished background growths in milliseconds
+    std::vector<action_prior> priors; ///< Priors of the root children of the next tree build
+    unsigned nb_virtual_visits; ///< Total number of virtual visits of the priors
+    bool opening_pending; ///< True if the tree is a loaded opening not used yet
+    decision_cache * decisions; ///< Decision cache of vanilla UCT, nullptr if none
+    unsigned nb_cache_hits; ///< Number of decisions answered by the decision cache
+    unsigned nb_cache_misses; ///< Number of decisions not answered by the decision cache
+    bool folding; ///< True if the mirrored states are folded (enabled, symmetric model and actions)
+    unsigned nb_root_actions; ///< Number of actions expanded at a folded root (0 if not folded)
 
     /** @brief Constructor */
-    agent(double _s, policy_parameters _p, model _m) : s(_s), p(_p), m(_m) {
+    basic_agent(double _s, policy_parameters _p, M _m) : s(_s), p(_p), m(_m) {
         a = 0;
+        peak_nb_nodes = 0;
+        peak_tree_bytes = 0;
+        nb_virtual_visits = 0;
+        speculation_seed = 0;
+        nb_speculations = 0;
+        speculation_cpu_ms = 0.;
+        opening_pending = false;
+        decisions = nullptr;
+        nb_cache_hits = 0;
+        nb_cache_misses = 0;
+        nb_root_actions = 0;
+        folding = p.symmetry_folding && M::mirror_symmetric && is_mirror_symmetric(p.action_space);
+        scores.reserve(p.action_space.size());
+        priors.reserve(p.action_space.size());
+        modes_values.reserve(2 * p.budget); // one mode per root sample at most, a kept root gathers samples
+        modes_counters.reserve(2 * p.budget); // over several builds, the capacity is kept beyond
+    }
+
+    /** @brief Destructor, wait for the background growth of the tree */
+    ~basic_agent() {
+        stop_speculation();
     }
 
     /** \brief Get the number of calls */
     unsigned get_nb_calls() {return m.nb_calls;}
 
+    /** @brief Get the peak number of nodes of the tree */
+    unsigned get_peak_nb_nodes() {return peak_nb_nodes;}
+
+    /** @brief Get the peak memory footprint of the tree in bytes */
+    size_t get_peak_tree_bytes() {return peak_tree_bytes;}
+
     /**
      * @brief UCT child
      *
@@ -173,16 +228,16 @@ struct agent {
      * @return Return the selected child according to the UCT formula
      */
     node * uct_child(node &v) {
-        std::vector<double> uct_scores;
+        scores.clear();
         for(auto &elt : v.children) {
             assert(elt.get_visits_count() != 0);
             assert(p.expd_counter > 0);
-            uct_scores.emplace_back(
+            scores.emplace_back(
                 elt.get_value() + 2 * p.uct_cst *
                 sqrt(log((double) p.expd_counter)/ ((double) elt.get_visits_count()))
             );
         }
-        unsigned ind = argmax(uct_scores);
+        unsigned ind = argmax(scores);
         return &v.children.at(ind);
     }
 
@@ -193,10 +248,18 @@ struct agent {
      * @return Return a pointer to the created leaf node
      */
     node * expand(node &v) {
+        PROFILE_PHASE(prof,PHASE_EXPAND);
         int nodes_action = v.get_next_expansion_action();
         double nodes_state = v.get_state_or_last();
         double new_state = m.transition_model(nodes_state,nodes_action);
         v.create_child(nodes_action,new_state);
+        if(v.is_root()) {
+            for(auto &pr : priors) {
+                if(pr.action == nodes_action && pr.nb_virtual_visits > 0) {
+                    v.get_last_child()->add_virtual_visits(pr.nb_virtual_visits,pr.value);
+                }
+            }
+        }
         return v.get_last_child();
     }
 
@@ -228,7 +291,7 @@ struct agent {
         if(v.is_root()) {
             return m.is_terminal(v.get_state());
         } else {
-            for(auto &elt: v.get_sampled_states()) {
+            for(auto elt: v.get_sampled_states_view()) {
                 if(!m.is_terminal(elt)) {
                     return false;
                 }
@@ -248,7 +311,7 @@ struct agent {
         if(is_node_terminal(v)) { // terminal
             sample_new_state(&v);
             return &v;
-        } else if(!v.is_fully_expanded()) { // expand node
+        } else if(!v.is_fully_expanded() && !(v.is_root() && nb_root_actions > 0 && v.get_nb_children() == nb_root_actions)) { // expand node, a folded root stops at the actions a >= 0
             return expand(v);
         } else { // apply UCT tree policy
             node * v_p = uct_child(v);
@@ -266,16 +329,7 @@ struct agent {
      * @return Return the epsilon-optimal action.
      */
     int epsilon_optimal_policy(double s) {
-        if(is_less_than(uniform_double(0.,1.),p.epsilon)) { // random action
-            return rand_element(p.action_space);
-        } else { // optimal action
-            int sgn = ((int)sign(s));
-            if(!is_less_than(m.model_failure_probability,.5)) {
-                sgn *= -1;
-            }
-            int mgn = (*std::max_element(p.action_space.begin(),p.action_space.end()));
-            return sgn * mgn;
-        }
+        return epsilon_optimal_action(m,p.action_space,p.epsilon,s);
     }
 
     /**
@@ -339,11 +393,11 @@ struct agent {
      * @return Return the indice of the child achieving the best score.
      */
     unsigned argmax_score(const node &v) {
-        std::vector<double> values;
+        scores.clear();
         for(auto &ch: v.children) {
-            values.push_back(ch.get_value());
+            scores.push_back(ch.get_value());
         }
-        return argmax(values);
+        return argmax(scores);
     }
 
     /**
@@ -362,6 +416,16 @@ struct agent {
         return v.get_action_at(indice);
     }
 
+    /**
+     * @brief Same state test
+     *
+     * Exact comparison if the states of the model are exactly represented (see
+     * 'generative_model::exact_states'), comparison up to 'COMPARISON_THRESHOLD' otherwise.
+     */
+    bool is_same_state(double s1, double s2) const {
+        return M::exact_states ? (s1 == s2) : is_equal_to(s1,s2);
+    }
+
     /**
      * @brief State multimodality test decision criterion
      *
@@ -372,24 +436,18 @@ struct agent {
      * @return Return 'true' if the tree is kept.
      */
     bool state_multimodality_test(double s) {
-        std::vector<double> modes_values;
-        std::vector<unsigned> modes_counters;
-        for(auto &si : p.root_node.get_sampled_states()) {
-            bool is_new_mode = true;
-            for(auto &m : modes_values) {
-                if(is_equal_to(si,m)) {
-                    is_new_mode = false;
-                }
+        modes_values.clear();
+        modes_counters.clear();
+        for(auto si : p.root_node.get_sampled_states_view()) {
+            unsigned j = 0;
+            while(j<modes_values.size() && !is_same_state(si,modes_values[j])) {
+                ++j;
             }
-            if(is_new_mode) {
+            if(j == modes_values.size()) { // new mode
                 modes_values.push_back(si);
                 modes_counters.push_back(1);
             } else {
-                for(unsigned j=0; j<modes_values.size(); ++j) {
-                    if(is_equal_to(si,modes_values[j])) {
-                        modes_counters.at(j)++;
-                    }
-                }
+                modes_counters[j]++;
             }
         }
         if(modes_values.size() == 1) { // mono-modal
@@ -399,10 +457,6 @@ struct agent {
                 return false;
             }
         } else { // multi-modal
-            std::vector<double> modes_ratio;
-            for(auto &elt: modes_counters) { // build modes ratio vector
-                modes_ratio.push_back(((double) elt) / ((double)p.root_node.get_sampled_states().size()));
-            }
             unsigned state_mode_indice = 0;
             for(unsigned j=0; j<modes_values.size(); ++j) {
                 if(s == modes_values[j]) {
@@ -411,7 +465,9 @@ struct agent {
                 }
             }
             double ratio_min = .8; // ratio under which we discard the tree
-            if(is_less_than(modes_ratio.at(state_mode_indice),ratio_min)) {
+            double state_mode_ratio = ((double) modes_counters.at(state_mode_indice))
+                / ((double) p.root_node.get_sampled_states_view().size());
+            if(is_less_than(state_mode_ratio,ratio_min)) {
                 return false;
             } else {
                 return true;
@@ -427,8 +483,7 @@ struct agent {
      * @return Return true if the test does not discard the tree.
      */
     bool state_distribution_variance_test() {
-        std::vector<double> states = p.root_node.get_sampled_states();
-        double var = var1d_estimator(states);
+        double var = var1d_estimator(p.root_node.get_sampled_states_view());
         return is_less_than(var,p.state_variance_threshold);
     }
 
@@ -443,7 +498,7 @@ struct agent {
      * @return Return true if the sub-tree is kept.
      */
     bool distance_to_state_distribution_mean_test(double s) {
-        std::vector<double> states = p.root_node.get_sampled_states();
+        const small_vector<double,2> &states = p.root_node.get_sampled_states_view();
         return is_less_than(mahalanobis1d_distance(s,states,1e-1),p.distance_threshold);
     }
 
@@ -455,28 +510,176 @@ struct agent {
      * @return Return true if the test does not discard the tree.
      */
     bool outcome_distribution_variance_test() {
-        std::vector<double> outcomes = p.root_node.get_sampled_outcomes();
-        double var = var1d_estimator(outcomes);
+        double var = p.root_node.get_outcomes_variance();
         return is_less_than(var,p.outcome_variance_threshold);
     }
 
+    /**
+     * @brief Update tree memory peaks
+     *
+     * Record the number of nodes and the memory footprint of the current tree if they
+     * exceed the peaks of the episode, both measured in a single walk of the tree.
+     * @return Return the memory footprint of the current tree in bytes.
+     */
+    size_t update_tree_memory_peaks() {
+        unsigned nb_nodes = 0;
+        size_t bytes = 0;
+        p.root_node.add_tree_size(nb_nodes,bytes);
+        peak_nb_nodes = std::max(peak_nb_nodes,nb_nodes);
+        peak_tree_bytes = std::max(peak_tree_bytes,bytes);
+        return bytes;
+    }
+
+    /**
+     * @brief Collect pruning candidates
+     *
+     * Collect the non-root nodes having children along with their depth. Recursive method.
+     * @param {node &} v; current node
+     * @param {unsigned} depth; depth of the current node
+     * @param {std::vector<std::pair<node *, unsigned>> &} candidates; collected nodes
+     */
+    void collect_pruning_candidates(
+        node &v,
+        unsigned depth,
+        std::vector<std::pair<node *, unsigned>> &candidates)
+    {
+        for(auto &ch : v.children) {
+            if(ch.get_nb_children() > 0) {
+                candidates.emplace_back(&ch,depth + 1);
+                collect_pruning_candidates(ch,depth + 1,candidates);
+            }
+        }
+    }
+
+    /**
+     * @brief Enforce the tree memory cap
+     *
+     * If the memory footprint of the tree exceeds the cap, first compact the sample
+     * histories of every node, then prune the sub-trees with the lowest visits counts
+     * until the footprint is below the cap. Deeper nodes are pruned first in case of
+     * equality so that a pruned node is never the descendant of a previously pruned one.
+     * @param {size_t} bytes; current memory footprint of the tree
+     */
+    void enforce_tree_memory_cap(size_t bytes) {
+        if(p.tree_memory_cap == 0 || bytes <= p.tree_memory_cap) {
+            return;
+        }
+        compact_histories(p.root_node);
+        bytes = p.root_node.get_memory_footprint();
+        if(bytes <= p.tree_memory_cap) {
+            return;
+        }
+        std::vector<std::pair<node *, unsigned>> candidates;
+        collect_pruning_candidates(p.root_node,0,candidates);
+        std::sort(candidates.begin(),candidates.end(),
+            [](const std::pair<node *, unsigned> &x, const std::pair<node *, unsigned> &y) {
+                if(x.first->get_visits_count() != y.first->get_visits_count()) {
+                    return x.first->get_visits_count() < y.first->get_visits_count();
+                }
+                return x.second > y.second;
+            }
+        );
+        for(auto &c : candidates) {
+            if(bytes <= p.tree_memory_cap) {
+                break;
+            }
+            size_t before = c.first->get_memory_footprint();
+            c.first->collapse();
+            bytes -= before - c.first->get_memory_footprint();
+        }
+    }
+
+    /**
+     * @brief Compact histories
+     *
+     * Compact the sample histories of every node of the tree. Recursive method.
+     * @param {node &} v; current node
+     */
+    void compact_histories(node &v) {
+        v.compact_history(p.history_keep);
+        for(auto &ch : v.children) {
+            compact_histories(ch);
+        }
+    }
+
     /**
      * @brief Build UCT tree
      *
      * Build a tree starting from the root attribute of the parameters using the
      * vanilla UCT algorithm. This is a 'void' method, the tree is kept in memory.
+     * With the symmetry folding, at the state 0 (invariant by the mirroring) and without
+     * priors, only the actions a >= 0 are searched with their share of the budget, then the
+     * sub-tree of each -a is the mirrored copy of the one of a.
      * @param {double} s; current state of the agent
      */
     void build_uct_tree(double s) {
+        TRACE_SCOPE("build_uct_tree");
+        perf_scope build_scope(p.perf_counters ? &build_counts : nullptr);
         p.root_node.clear_node();
         p.root_node.set_state(s);
-        p.expd_counter = 0;
-        for(unsigned i=0; i<p.budget; ++i) {
-            node *ptr = tree_policy(p.root_node);
-            double total_return = default_policy(ptr);
-            backup(total_return,ptr);
+        p.expd_counter = nb_virtual_visits; // the virtual visits are deducted from the budget
+        unsigned budget = p.budget;
+        bool symmetric_root = folding && priors.empty() && s == 0.; // exactly invariant by the mirroring
+        if(symmetric_root) { // only the canonical actions are searched, with their share of the budget
+            unsigned nb_actions = p.root_node.get_nb_of_actions();
+            nb_root_actions = p.root_node.fold_actions();
+            budget = (p.budget * nb_root_actions + nb_actions - 1) / nb_actions;
+        }
+        for(unsigned i=nb_virtual_visits; i<budget; ++i) {
+            node *ptr = nullptr;
+            double total_return = 0.;
+            {
+                PROFILE_PHASE(prof,PHASE_TREE_POLICY);
+                ptr = tree_policy(p.root_node);
+            }
+            {
+                PROFILE_PHASE(prof,PHASE_DEFAULT_POLICY);
+                perf_scope rollout_scope(p.perf_counters ? &rollout_counts : nullptr,PERF_ROLLOUT_SAMPLING_PERIOD);
+                total_return = default_policy(ptr);
+            }
+            {
+                PROFILE_PHASE(prof,PHASE_BACKUP);
+                backup(total_return,ptr);
+            }
             p.expd_counter += 1;
         }
+        if(symmetric_root) {
+            p.root_node.unfold_actions();
+            nb_root_actions = 0;
+        }
+        priors.clear();
+        nb_virtual_visits = 0;
+        size_t bytes = update_tree_memory_peaks();
+        if(p.tree_memory_cap > 0) {
+            enforce_tree_memory_cap(bytes);
+        }
+    }
+
+    /**
+     * @brief Collect priors
+     *
+     * Keep the value of each child of the current root as the prior of its action for the
+     * next tree build, with 'p.warm_start_confidence' times its visits as virtual visits. The
+     * virtual visits are scaled down so that the build still runs at least one iteration per
+     * action.
+     */
+    void collect_priors() {
+        priors.clear();
+        nb_virtual_visits = 0;
+        for(auto &ch : p.root_node.children) {
+            unsigned nb_visits = (unsigned) (p.warm_start_confidence * ch.get_visits_count());
+            priors.push_back(action_prior{ch.get_incoming_action(),ch.get_value(),nb_visits});
+            nb_virtual_visits += nb_visits;
+        }
+        unsigned max_virtual_visits = (p.budget > p.action_space.size()) ? p.budget - p.action_space.size() : 0;
+        if(nb_virtual_visits > max_virtual_visits) {
+            double ratio = ((double) max_virtual_visits) / ((double) nb_virtual_visits);
+            nb_virtual_visits = 0;
+            for(auto &pr : priors) {
+                pr.nb_virtual_visits = (unsigned) (ratio * pr.nb_virtual_visits);
+                nb_virtual_visits += pr.nb_virtual_visits;
+            }
+        }
     }
 
     /**
@@ -490,15 +693,19 @@ struct agent {
     bool decision_criterion(double s) {
         bool keep_tree = true;
         if(p.decision_criteria_selector[1]) { // state multi-modality
+            PROFILE_PHASE(prof,PHASE_STATE_MULTIMODALITY);
             keep_tree *= state_multimodality_test(s);
         }
         if(p.decision_criteria_selector[2]) { // state distribution variance
+            PROFILE_PHASE(prof,PHASE_STATE_VARIANCE);
             keep_tree *= state_distribution_variance_test();
         }
         if(p.decision_criteria_selector[3]) { // distance to state distribution mean
+            PROFILE_PHASE(prof,PHASE_STATE_DISTANCE);
             keep_tree *= distance_to_state_distribution_mean_test(s);
         }
         if(p.decision_criteria_selector[4]) { // outcome distribution variance
+            PROFILE_PHASE(prof,PHASE_OUTCOME_VARIANCE);
             keep_tree *= outcome_distribution_variance_test();
         }
         return keep_tree;
@@ -512,24 +719,175 @@ struct agent {
      * @return Return the recommended action.
      */
     int oluct(double s) {
-        if(!p.root_node.is_fully_expanded() || !decision_criterion(s)) {
+        if(opening_pending) { // built at this very state
+            TRACE_INSTANT("opening_reuse");
+        } else if(!p.root_node.is_fully_expanded() || !decision_criterion(s)) {
+            TRACE_INSTANT("tree_rebuild");
+            if(p.warm_start) {
+                collect_priors();
+            }
             build_uct_tree(s);
+        } else {
+            TRACE_INSTANT("tree_reuse");
         }
         unsigned indice = 0;
         int recommended_action = get_recommended_action(p.root_node,indice);
         p.root_node.move_to_child(indice,s);
+        if(p.tree_memory_cap > 0) {
+            enforce_tree_memory_cap(p.root_node.get_memory_footprint());
+        }
         return recommended_action;
     }
 
     /**
      * @brief Vanilla UCT
+     *
+     * If a decision cache is set, the memoized decision at the state is returned if any;
+     * otherwise the decision is memoized. With the symmetry folding, the tree is built at
+     * the canonical state |s| and its recommended action is mirrored back if s < 0, so that
+     * a state and its mirror share their memoized decision.
      * @param {double} s; current state of the agent
      * @return Return the recommended action.
      */
     int vanilla_uct(double s) {
-        build_uct_tree(s);
+        int mirror = (folding && !opening_pending && s < 0.) ? -1 : 1; // the opening is not folded
+        s *= (double) mirror;
+        if(decisions != nullptr && !opening_pending) {
+            decision_entry entry;
+            if(decisions->find(s,entry)) {
+                TRACE_INSTANT("decision_cache_hit");
+                ++nb_cache_hits;
+                return mirror * entry.action;
+            }
+            ++nb_cache_misses;
+        }
+        if(!opening_pending) {
+            build_uct_tree(s);
+        }
         unsigned indice = 0;
-        return get_recommended_action(p.root_node,indice);
+        int recommended_action = get_recommended_action(p.root_node,indice);
+        if(decisions != nullptr) {
+            const node &ch = p.root_node.children[indice];
+            decisions->insert(s,decision_entry{recommended_action,ch.get_value(),ch.get_visits_count()});
+        }
+        return mirror * recommended_action;
+    }
+
+    /**
+     * @brief Speculate
+     *
+     * Grow the current tree from the sampled states of its root, i.e. the likely next
+     * states, until the budget of the speculation is spent or a stop is requested. Called by
+     * the background thread; the free nodes of the pool of the agent thread are taken first
+     * so that the nodes do not pile up in one of the pools.
+     * @param {node_pool &} owner_pool; node pool of the agent thread
+     * @param {std::atomic<bool> &} stop; stop request
+     */
+    void speculate(node_pool &owner_pool, std::atomic<bool> &stop) {
+        TRACE_SCOPE("speculate");
+        unsigned budget = (p.speculation_budget == 0) ? p.budget : p.speculation_budget;
+        local_node_pool().transfer(owner_pool,budget);
+        const small_vector<double,2> &states = p.root_node.get_sampled_states_view();
+        double root_state = p.root_node.get_state();
+        for(unsigned i=0; i<budget && !stop; ++i) {
+            double s0 = states[std::uniform_int_distribution<unsigned>(0,states.size()-1)(random_engine())];
+            if(m.is_terminal(s0)) { // no decision is taken at a terminal state
+                continue;
+            }
+            p.root_node.set_state(s0);
+            node * ptr = tree_policy(p.root_node);
+            double total_return = default_policy(ptr);
+            backup(total_return,ptr);
+            p.expd_counter += 1;
+        }
+        p.root_node.set_state(root_state);
+    }
+
+    /**
+     * @brief Start the speculation
+     *
+     * If the speculative planning is enabled and the policy is OLUCT, start growing the kept
+     * sub-tree on the background thread of the calling thread (see
+     * 'local_speculation_pool'). Only a fully expanded sub-tree is grown, so that the
+     * speculation does not change the decision to keep the tree. The agent should not be used
+     * until 'stop_speculation' is called, the thread may only step the environment in the
+     * meantime. The random engine of the background thread is seeded from
+     * 'speculation_seed' and the index of the speculation, but the number of background
+     * expansions depends on when 'stop_speculation' is called: an episode is reproducible only
+     * if every speculation spends its whole budget before being stopped.
+     */
+    void start_speculation() {
+        if(!p.speculative_planning || (p.policy_selector != 1 && p.policy_selector != 2)
+            || !p.root_node.is_fully_expanded()) { // a partially expanded tree is rebuilt anyway
+            return;
+        }
+        unsigned long long seed = (speculation_seed != 0) ?
+            mix_seed(speculation_seed,nb_speculations) : (unsigned long long) std::random_device{}();
+        ++nb_speculations;
+        speculation = std::make_shared<speculation_task>();
+        node_pool * owner_pool = &local_node_pool();
+        std::shared_ptr<speculation_task> task = speculation;
+        task->done = local_speculation_pool().submit([this,owner_pool,task,seed]() {
+            random_engine().seed(seed);
+            double cpu_start = thread_cpu_time_ms();
+            speculate(*owner_pool,task->stop);
+            task->cpu_ms = thread_cpu_time_ms() - cpu_start;
+        });
+    }
+
+    /**
+     * @brief Stop the speculation
+     *
+     * Stop the background growth of the tree, if any, and wait for it. Its CPU time is added
+     * to 'speculation_cpu_ms'.
+     */
+    void stop_speculation() {
+        if(!speculation) {
+            return;
+        }
+        speculation->stop = true;
+        speculation->done.get();
+        speculation_cpu_ms += speculation->cpu_ms;
+        speculation.reset();
+        size_t bytes = update_tree_memory_peaks();
+        if(p.tree_memory_cap > 0) {
+            enforce_tree_memory_cap(bytes);
+        }
+    }
+
+    /**
+     * @brief Load an opening
+     *
+     * Replace the tree with a clone of an opening tree built at the current state (see
+     * 'opening_cache'), used by the next decision instead of a new tree.
+     * @param {const node &} opening; opening tree
+     */
+    void load_opening(const node &opening) {
+        p.root_node.clone_from(opening);
+        opening_pending = p.root_node.is_fully_expanded();
+        update_tree_memory_peaks();
+    }
+
+    /**
+     * @brief Expectimax
+     *
+     * Plan with a depth-limited expectimax search (see 'expectimax_search'): exact
+     * expectations and memoized values if the model enumerates its outcomes, sparse sampling
+     * otherwise. With the symmetry folding, the mirrored states share their memo entries.
+     * No tree is kept between the decisions.
+     * @param {double} s; current state of the agent
+     * @return Return the recommended action.
+     */
+    int expectimax(double s) {
+        TRACE_SCOPE("expectimax");
+        expectimax_search<M> search(m,p.action_space,p.discount_factor,p.epsilon,p.horizon,p.sparse_sampling_width,folding);
+        unsigned depth = search.is_exact ? p.expectimax_depth : p.sparse_sampling_depth;
+        thread_pool * pool = nullptr;
+        if(p.expectimax_threads != 1) {
+            pool = &search_thread_pool(p.expectimax_threads);
+        }
+        search.plan(s,std::max(depth,1u),pool,scores);
+        return p.action_space[argmax(scores)];
     }
 
     /**
@@ -564,6 +922,7 @@ struct agent {
      * memory.
      */
     void take_action() {
+        TRACE_SCOPE("take_action");
         switch(p.policy_selector) {
             case 0: { // vanilla UCT
                 a = vanilla_uct(s);
@@ -577,12 +936,20 @@ struct agent {
                 a = oluct(s);
                 break;
             }
+            case 3: { // expectimax
+                a = expectimax(s);
+                break;
+            }
             default : { // epsilon-optimal policy
                 a = epsilon_optimal_policy(s);
                 break;
             }
         }
+        opening_pending = false;
     }
 };
 
+/** @brief Agent planning with the model matching the environment */
+typedef basic_agent<model> agent;
+
 #endif // AGENT_HPP_
@@ -0,0 +1,363 @@
+#ifndef AGGREGATE_HPP_
+#define AGGREGATE_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Running histogram
+ *
+ * Log-linear histogram of signed values in constant memory: each power of two is split into
+ * 'NB_SUB_BUCKETS' buckets, hence the quantiles have a relative error below 1/16. Magnitudes
+ * below 2^'MIN_EXPONENT' fall into the zero bucket, magnitudes above 2^'MAX_EXPONENT' into the
+ * last bucket. Two histograms are merged by adding their counts.
+ */
+struct running_histogram {
+    static const unsigned NB_SUB_BUCKETS = 16; ///< Number of buckets per power of two
+    static const int MIN_EXPONENT = -20; ///< Smallest distinguished power of two
+    static const int MAX_EXPONENT = 44; ///< Largest distinguished power of two
+    static const unsigned NB_BUCKETS = (MAX_EXPONENT - MIN_EXPONENT) * NB_SUB_BUCKETS; ///< Per sign
+    unsigned long long positive[NB_BUCKETS]; ///< Counts of the positive values
+    unsigned long long negative[NB_BUCKETS]; ///< Counts of the negative values (by magnitude)
+    unsigned long long nb_zeros; ///< Count of the zero bucket
+
+    /** @brief Constructor */
+    running_histogram() {
+        reset();
+    }
+
+    /** @brief Number of values of the mergeable state, see 'get_state' */
+    static const unsigned NB_STATE_VALUES = 2 * NB_BUCKETS + 1;
+
+    /** @brief Reset the histogram */
+    void reset() {
+        for(unsigned i=0; i<NB_BUCKETS; ++i) {
+            positive[i] = 0;
+            negative[i] = 0;
+        }
+        nb_zeros = 0;
+    }
+
+    /** @brief Get the indice of the bucket of a positive magnitude, -1 for the zero bucket */
+    static int bucket_of(double magnitude) {
+        int e = 0;
+        double m = std::frexp(magnitude,&e); // magnitude = m * 2^e with m in [.5,1)
+        if(magnitude == 0. || e <= MIN_EXPONENT) {
+            return -1;
+        }
+        int ind = (e - 1 - MIN_EXPONENT) * (int) NB_SUB_BUCKETS + (int) ((2. * m - 1.) * NB_SUB_BUCKETS);
+        return std::min(ind,(int) NB_BUCKETS - 1);
+    }
+
+    /** @brief Get the middle of a bucket */
+    static double bucket_middle(unsigned ind) {
+        int e = (int) (ind / NB_SUB_BUCKETS) + MIN_EXPONENT;
+        double sub = (double) (ind % NB_SUB_BUCKETS) + .5;
+        return std::ldexp(1. + sub / NB_SUB_BUCKETS,e);
+    }
+
+    /** @brief Record a value (not NaN) */
+    void record(double v) {
+        int ind = bucket_of(std::fabs(v));
+        if(ind < 0) {
+            ++nb_zeros;
+        } else if(v > 0.) {
+            ++positive[ind];
+        } else {
+            ++negative[ind];
+        }
+    }
+
+    /** @brief Append the counts (zeros, positive then negative buckets) to a vector */
+    void get_state(std::vector<double> &state) const {
+        state.push_back((double) nb_zeros);
+        state.insert(state.end(),positive,positive + NB_BUCKETS);
+        state.insert(state.end(),negative,negative + NB_BUCKETS);
+    }
+
+    /** @brief Set the counts from 'NB_STATE_VALUES' values written by 'get_state' */
+    void set_state(const double * state) {
+        nb_zeros = (unsigned long long) state[0];
+        for(unsigned i=0; i<NB_BUCKETS; ++i) {
+            positive[i] = (unsigned long long) state[1 + i];
+            negative[i] = (unsigned long long) state[1 + NB_BUCKETS + i];
+        }
+    }
+
+    /** @brief Merge another histogram into this one */
+    void merge(const running_histogram &other) {
+        for(unsigned i=0; i<NB_BUCKETS; ++i) {
+            positive[i] += other.positive[i];
+            negative[i] += other.negative[i];
+        }
+        nb_zeros += other.nb_zeros;
+    }
+
+    /**
+     * @brief Quantile
+     *
+     * @param {double} q; quantile level in [0,1]
+     * @param {unsigned long long} count; number of recorded values
+     * @return Return the middle of the bucket containing the quantile.
+     */
+    double quantile(double q, unsigned long long count) const {
+        unsigned long long rank = (unsigned long long) std::ceil(q * (double) count);
+        rank = std::max(rank,1ULL);
+        unsigned long long cumul = 0;
+        for(unsigned i=NB_BUCKETS; i-->0;) { // negative values, decreasing magnitudes
+            cumul += negative[i];
+            if(cumul >= rank) {
+                return -bucket_middle(i);
+            }
+        }
+        cumul += nb_zeros;
+        if(cumul >= rank) {
+            return 0.;
+        }
+        for(unsigned i=0; i<NB_BUCKETS; ++i) {
+            cumul += positive[i];
+            if(cumul >= rank) {
+                return bucket_middle(i);
+            }
+        }
+        return 0.;
+    }
+};
+
+/**
+ * @brief Running statistics
+ *
+ * Streaming statistics of a saved value in constant memory: count, mean and variance
+ * (Welford's algorithm), minimum, maximum and quantiles (see 'running_histogram'). NaN values
+ * are counted apart. Statistics gathered by different threads are merged with 'merge'.
+ */
+struct running_stats {
+    unsigned long long count; ///< Number of recorded values (NaN excluded)
+    unsigned long long nb_nan; ///< Number of recorded NaN
+    double mean; ///< Mean
+    double m2; ///< Sum of the squared deviations to the mean
+    double min; ///< Minimum
+    double max; ///< Maximum
+    running_histogram hist; ///< Histogram for the quantiles
+
+    /** @brief Number of values of the mergeable state, see 'get_state' */
+    static const unsigned NB_STATE_VALUES = 6 + running_histogram::NB_STATE_VALUES;
+
+    /** @brief Constructor */
+    running_stats() {
+        reset();
+    }
+
+    /** @brief Reset the statistics */
+    void reset() {
+        count = 0;
+        nb_nan = 0;
+        mean = 0.;
+        m2 = 0.;
+        min = std::numeric_limits<double>::infinity();
+        max = -std::numeric_limits<double>::infinity();
+        hist.reset();
+    }
+
+    /**
+     * @brief Get the mergeable state
+     *
+     * Append count, number of NaN, mean, m2, min, max and the histogram counts to a vector,
+     * so that statistics saved by different processes can be merged.
+     */
+    void get_state(std::vector<double> &state) const {
+        state.push_back((double) count);
+        state.push_back((double) nb_nan);
+        state.push_back(mean);
+        state.push_back(m2);
+        state.push_back(min);
+        state.push_back(max);
+        hist.get_state(state);
+    }
+
+    /** @brief Set the state from 'NB_STATE_VALUES' values written by 'get_state' */
+    void set_state(const double * state) {
+        count = (unsigned long long) state[0];
+        nb_nan = (unsigned long long) state[1];
+        mean = state[2];
+        m2 = state[3];
+        min = state[4];
+        max = state[5];
+        hist.set_state(state + 6);
+    }
+
+    /** @brief Record a value */
+    void record(double v) {
+        if(v != v) {
+            ++nb_nan;
+            return;
+        }
+        ++count;
+        double delta = v - mean;
+        mean += delta / (double) count;
+        m2 += delta * (v - mean);
+        min = std::min(min,v);
+        max = std::max(max,v);
+        hist.record(v);
+    }
+
+    /** @brief Merge other statistics into these ones (Chan et al. pairwise update) */
+    void merge(const running_stats &other) {
+        if(other.count > 0) {
+            double n = (double) (count + other.count);
+            double delta = other.mean - mean;
+            mean += delta * (double) other.count / n;
+            m2 += other.m2 + delta * delta * (double) count * (double) other.count / n;
+            count += other.count;
+            min = std::min(min,other.min);
+            max = std::max(max,other.max);
+            hist.merge(other.hist);
+        }
+        nb_nan += other.nb_nan;
+    }
+
+    /** @brief Get the unbiased variance, NaN if less than 2 values */
+    double variance() const {
+        return (count > 1) ? m2 / (double) (count - 1) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /** @brief Get the standard deviation, NaN if less than 2 values */
+    double stddev() const {
+        return std::sqrt(variance());
+    }
+
+    /** @brief Get a quantile clamped by the extrema, NaN if no value */
+    double quantile(double q) const {
+        if(count == 0) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return std::min(std::max(hist.quantile(q,count),min),max);
+    }
+};
+
+/**
+ * @brief Normal quantile
+ *
+ * Quantile of the standard normal distribution, computed by bisection of its cumulative
+ * distribution function.
+ * @param {double} p; probability in (0,1)
+ * @return Return x such that P(X <= x) = p.
+ */
+double normal_quantile(double p) {
+    double lo = -40., hi = 40.;
+    for(unsigned i=0; i<100; ++i) {
+        double mid = .5 * (lo + hi);
+        if(.5 * std::erfc(-mid / std::sqrt(2.)) < p) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return .5 * (lo + hi);
+}
+
+/**
+ * @brief Confidence interval width
+ *
+ * Width of the normal confidence interval on the mean of the recorded values.
+ * @param {const running_stats &} stats; statistics of the recorded values
+ * @param {double} confidence; confidence level in (0,1), e.g. .95
+ * @return Return the full width of the interval, infinity if less than 2 values.
+ */
+double confidence_interval_width(const running_stats &stats, double confidence) {
+    if(stats.count < 2) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double z = normal_quantile(.5 * (1. + confidence));
+    return 2. * z * stats.stddev() / std::sqrt((double) stats.count);
+}
+
+/**
+ * @brief Get the summary statistics names
+ *
+ * @return Return the name suffix of each statistic in the order of 'get_summary'.
+ */
+std::vector<std::string> get_summary_statistics_names() {
+    return std::vector<std::string>{"mean", "std", "min", "max", "p50", "p90", "p99"};
+}
+
+/**
+ * @brief Episode aggregate
+ *
+ * Running statistics of every saved value of the episodes of a configuration.
+ */
+struct episode_aggregate {
+    unsigned long long nb_episodes; ///< Number of recorded episodes
+    std::vector<running_stats> columns; ///< Statistics of each saved value
+
+    /** @brief Constructor */
+    explicit episode_aggregate(unsigned nb_columns) : nb_episodes(0), columns(nb_columns) {}
+
+    /** @brief Reset the statistics */
+    void reset() {
+        nb_episodes = 0;
+        for(auto &c : columns) {
+            c.reset();
+        }
+    }
+
+    /** @brief Record the saved values of an episode */
+    void record(const std::vector<double> &row) {
+        assert(row.size() == columns.size());
+        ++nb_episodes;
+        for(unsigned j=0; j<row.size(); ++j) {
+            columns[j].record(row[j]);
+        }
+    }
+
+    /** @brief Merge another aggregate into this one */
+    void merge(const episode_aggregate &other) {
+        assert(other.columns.size() == columns.size());
+        nb_episodes += other.nb_episodes;
+        for(unsigned j=0; j<columns.size(); ++j) {
+            columns[j].merge(other.columns[j]);
+        }
+    }
+
+    /**
+     * @brief Get the summary
+     *
+     * @return Return the summary row: the number of episodes then the statistics of each
+     * saved value in the order of 'get_summary_names'.
+     */
+    std::vector<double> get_summary() const {
+        std::vector<double> v = {(double) nb_episodes};
+        for(auto &c : columns) {
+            v.push_back((c.count > 0) ? c.mean : std::numeric_limits<double>::quiet_NaN());
+            v.push_back(c.stddev());
+            v.push_back((c.count > 0) ? c.min : std::numeric_limits<double>::quiet_NaN());
+            v.push_back((c.count > 0) ? c.max : std::numeric_limits<double>::quiet_NaN());
+            v.push_back(c.quantile(.5));
+            v.push_back(c.quantile(.9));
+            v.push_back(c.quantile(.99));
+        }
+        return v;
+    }
+};
+
+/**
+ * @brief Get the summary names
+ *
+ * @param {const std::vector<std::string> &} names; the names of the saved values
+ * @return Return the names of the summary row, e.g. 'score_mean'.
+ */
+std::vector<std::string> get_summary_names(const std::vector<std::string> &names) {
+    std::vector<std::string> v = {"nb_episodes"};
+    for(auto &name : names) {
+        for(auto &stat : get_summary_statistics_names()) {
+            v.push_back(name + "_" + stat);
+        }
+    }
+    return v;
+}
+
+#endif // AGGREGATE_HPP_
@@ -0,0 +1,304 @@
+#ifndef COLUMNAR_HPP_
+#define COLUMNAR_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary columnar result format
+ *
+ * Layout of a '.bin' result file, every integer and float being little-endian:
+ * - magic "1DTRCOL" followed by a null byte (8 bytes);
+ * - uint32 version; uint32 number of columns; uint64 number of rows;
+ * - for each column: uint32 length of the name; the name (not null terminated); uint8 type
+ * (0: float64);
+ * - zero padding up to a multiple of 64 bytes;
+ * - the columns, one after the other, each being an array of 'number of rows' float64.
+ * Hence each column can be memory-mapped directly (see 'plot/columnar.py').
+ */
+constexpr char COLUMNAR_MAGIC[8] = {'1','D','T','R','C','O','L','\0'};
+constexpr uint32_t COLUMNAR_VERSION = 1;
+constexpr uint8_t COLUMNAR_FLOAT64 = 0;
+constexpr unsigned COLUMNAR_ALIGNMENT = 64;
+
+/** @brief Test if the host is little-endian */
+inline bool is_little_endian() {
+    const uint16_t one = 1;
+    unsigned char first = 0;
+    std::memcpy(&first,&one,1);
+    return first == 1;
+}
+
+/**
+ * @brief Checked write
+ *
+ * Write bytes to a file, throw if they are not all written.
+ * @param {std::FILE *} file; output file
+ * @param {const void *} data; written bytes
+ * @param {size_t} size; number of bytes
+ */
+inline void write_bytes(std::FILE * file, const void * data, size_t size) {
+    if(size > 0 && std::fwrite(data,1,size,file) != size) {
+        throw std::runtime_error("cannot write the result file");
+    }
+}
+
+/**
+ * @brief Write little-endian
+ *
+ * Write the bytes of a trivially copyable value in little-endian order. Template method.
+ */
+template <class T>
+void write_little_endian(std::FILE * file, T value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes,&value,sizeof(T));
+    if(!is_little_endian()) {
+        for(unsigned i=0; i<sizeof(T)/2; ++i) {
+            std::swap(bytes[i],bytes[sizeof(T)-1-i]);
+        }
+    }
+    write_bytes(file,bytes,sizeof(T));
+}
+
+/**
+ * @brief Columnar writer
+ *
+ * Writer of the binary columnar result format. The header is written at the opening with a
+ * placeholder number of rows. The rows are buffered column-wise by chunks of 'chunk_rows'
+ * rows; a full chunk is appended to a temporary file next to the output, the chunks of the
+ * columns being interleaved. 'close' (or the destructor) copies each column from the
+ * temporary file to the output, removes the temporary file and patches the number of rows,
+ * hence the memory use does not grow with the number of rows.
+ */
+struct columnar_writer {
+    std::string output_path; ///< Output path
+    std::string chunks_path; ///< Path of the temporary file of the full chunks
+    std::FILE * file; ///< Output file
+    std::FILE * chunks; ///< Temporary file of the full chunks
+    std::vector<std::vector<double>> columns; ///< Current chunk of each column
+    size_t chunk_rows; ///< Number of rows per chunk
+    uint64_t nb_full_chunks; ///< Number of chunks written to the temporary file
+    bool closed; ///< True once the file is written
+
+    /**
+     * @brief Constructor
+     *
+     * Open the output file and write its header.
+     * @param {const std::string &} _output_path; the output path
+     * @param {const std::vector<std::string> &} names; the names of the columns
+     * @param {size_t} _chunk_rows; number of rows per chunk
+     */
+    columnar_writer(
+        const std::string &_output_path,
+        const std::vector<std::string> &names,
+        size_t _chunk_rows = 8192) :
+        output_path(_output_path),
+        chunks_path(_output_path + ".chunks"),
+        file(nullptr),
+        chunks(nullptr),
+        columns(names.size()),
+        chunk_rows(std::max(_chunk_rows,(size_t) 1)),
+        nb_full_chunks(0),
+        closed(false)
+    {
+        file = std::fopen(output_path.c_str(),"wb");
+        if(file == nullptr) {
+            throw std::runtime_error("cannot open result file " + output_path);
+        }
+        try {
+            write_bytes(file,COLUMNAR_MAGIC,sizeof(COLUMNAR_MAGIC));
+            write_little_endian<uint32_t>(file,COLUMNAR_VERSION);
+            write_little_endian<uint32_t>(file,(uint32_t) names.size());
+            write_little_endian<uint64_t>(file,0); // patched by 'close'
+            size_t header_size = sizeof(COLUMNAR_MAGIC) + 16;
+            for(auto &name : names) {
+                write_little_endian<uint32_t>(file,(uint32_t) name.size());
+                write_bytes(file,name.data(),name.size());
+                write_little_endian<uint8_t>(file,COLUMNAR_FLOAT64);
+                header_size += 4 + name.size() + 1;
+            }
+            const char padding[COLUMNAR_ALIGNMENT] = {};
+            write_bytes(file,padding,(COLUMNAR_ALIGNMENT - header_size % COLUMNAR_ALIGNMENT) % COLUMNAR_ALIGNMENT);
+            chunks = std::fopen(chunks_path.c_str(),"w+b");
+            if(chunks == nullptr) {
+                throw std::runtime_error("cannot open temporary file " + chunks_path);
+            }
+        } catch(...) {
+            std::fclose(file);
+            throw;
+        }
+        for(auto &col : columns) {
+            col.reserve(chunk_rows);
+        }
+    }
+
+    /** @brief Destructor, write the file if not done yet, use 'close' to get the errors */
+    ~columnar_writer() {
+        if(!closed) {
+            try {
+                close();
+            } catch(const std::exception &) {}
+        }
+    }
+
+    columnar_writer(const columnar_writer &) = delete;
+    columnar_writer & operator=(const columnar_writer &) = delete;
+
+    /**
+     * @brief Write a row
+     *
+     * @param {const std::vector<double> &} v; row, one value per column
+     */
+    void write_row(const std::vector<double> &v) {
+        assert(!closed && v.size() == columns.size());
+        for(unsigned j=0; j<v.size(); ++j) {
+            columns[j].push_back(v[j]);
+        }
+        if(!columns.empty() && columns[0].size() == chunk_rows) {
+            for(auto &col : columns) {
+                write_values(chunks,col.data(),col.size());
+                col.clear();
+            }
+            ++nb_full_chunks;
+        }
+    }
+
+    /**
+     * @brief Write values
+     *
+     * Write doubles in little-endian order.
+     */
+    static void write_values(std::FILE * out, const double * values, size_t nb) {
+        if(is_little_endian()) {
+            write_bytes(out,values,nb * sizeof(double));
+        } else {
+            for(size_t i=0; i<nb; ++i) {
+                write_little_endian<double>(out,values[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Close
+     *
+     * Copy the columns to the output file, patch the number of rows and close the files.
+     * Throw if a write fails; the number of rows is only patched once every column is
+     * written, hence an incomplete file reads as empty.
+     */
+    void close() {
+        closed = true;
+        bool failed = false;
+        try {
+            uint64_t nb_rows = nb_full_chunks * chunk_rows + (columns.empty() ? 0 : columns[0].size());
+            size_t chunk_bytes = chunk_rows * sizeof(double);
+            std::vector<char> buffer(chunk_bytes);
+            for(unsigned j=0; j<columns.size(); ++j) {
+                for(uint64_t k=0; k<nb_full_chunks; ++k) { // already little-endian
+                    long offset = (long) ((k * columns.size() + j) * chunk_bytes);
+                    if(std::fseek(chunks,offset,SEEK_SET) != 0
+                        || std::fread(buffer.data(),1,chunk_bytes,chunks) != chunk_bytes) {
+                        throw std::runtime_error("cannot read temporary file " + chunks_path);
+                    }
+                    write_bytes(file,buffer.data(),chunk_bytes);
+                }
+                write_values(file,columns[j].data(),columns[j].size());
+            }
+            if(std::fseek(file,sizeof(COLUMNAR_MAGIC) + 8,SEEK_SET) != 0) {
+                throw std::runtime_error("cannot write the result file");
+            }
+            write_little_endian<uint64_t>(file,nb_rows);
+        } catch(...) {
+            failed = true;
+        }
+        failed |= (std::fclose(file) != 0);
+        std::fclose(chunks);
+        std::remove(chunks_path.c_str());
+        if(failed) {
+            throw std::runtime_error("cannot write result file " + output_path);
+        }
+    }
+};
+
+/**
+ * @brief Read little-endian
+ *
+ * Read a trivially copyable value written by 'write_little_endian', throw at the end of the
+ * file. Template method.
+ */
+template <class T>
+T read_little_endian(std::FILE * file) {
+    unsigned char bytes[sizeof(T)];
+    if(std::fread(bytes,1,sizeof(T),file) != sizeof(T)) {
+        throw std::runtime_error("truncated columnar file");
+    }
+    if(!is_little_endian()) {
+        for(unsigned i=0; i<sizeof(T)/2; ++i) {
+            std::swap(bytes[i],bytes[sizeof(T)-1-i]);
+        }
+    }
+    T value;
+    std::memcpy(&value,bytes,sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Read a columnar file
+ *
+ * Read a whole file of the binary columnar result format.
+ * @param {const std::string &} path; input path
+ * @param {std::vector<std::string> &} names; filled with the names of the columns
+ * @return Return the columns.
+ */
+std::vector<std::vector<double>> read_columnar(const std::string &path, std::vector<std::string> &names) {
+    std::FILE * file = std::fopen(path.c_str(),"rb");
+    if(file == nullptr) {
+        throw std::runtime_error("cannot open columnar file " + path);
+    }
+    std::vector<std::vector<double>> columns;
+    try {
+        char magic[sizeof(COLUMNAR_MAGIC)];
+        if(std::fread(magic,1,sizeof(magic),file) != sizeof(magic)
+            || std::memcmp(magic,COLUMNAR_MAGIC,sizeof(magic)) != 0
+            || read_little_endian<uint32_t>(file) != COLUMNAR_VERSION) {
+            throw std::runtime_error(path + " is not a columnar file");
+        }
+        uint32_t nb_columns = read_little_endian<uint32_t>(file);
+        uint64_t nb_rows = read_little_endian<uint64_t>(file);
+        size_t header_size = sizeof(COLUMNAR_MAGIC) + 16;
+        names.clear();
+        for(uint32_t j=0; j<nb_columns; ++j) {
+            uint32_t length = read_little_endian<uint32_t>(file);
+            std::string name(length,'\0');
+            if(length > 0 && std::fread(&name[0],1,length,file) != length) {
+                throw std::runtime_error("truncated columnar file");
+            }
+            if(read_little_endian<uint8_t>(file) != COLUMNAR_FLOAT64) {
+                throw std::runtime_error(path + ": unsupported column type");
+            }
+            names.push_back(name);
+            header_size += 4 + length + 1;
+        }
+        if(std::fseek(file,(long) ((header_size + COLUMNAR_ALIGNMENT - 1) / COLUMNAR_ALIGNMENT * COLUMNAR_ALIGNMENT),SEEK_SET) != 0) {
+            throw std::runtime_error("truncated columnar file");
+        }
+        columns.assign(nb_columns,std::vector<double>(nb_rows));
+        for(auto &col : columns) {
+            for(auto &v : col) {
+                v = read_little_endian<double>(file);
+            }
+        }
+    } catch(...) {
+        std::fclose(file);
+        throw;
+    }
+    std::fclose(file);
+    return columns;
+}
+
+#endif // COLUMNAR_HPP_
@@ -0,0 +1,144 @@
+#ifndef DECISION_CACHE_HPP_
+#define DECISION_CACHE_HPP_
+
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Decision entry
+ *
+ * Decision of vanilla UCT at a state, with the statistics of the recommended root child.
+ */
+struct decision_entry {
+    int action; ///< Recommended action
+    double value; ///< Value of the recommended action
+    unsigned nb_visits; ///< Number of visits of the recommended action
+};
+
+/**
+ * @brief Decision cache
+ *
+ * Concurrent memo of the decisions of vanilla UCT keyed by quantized state, shared by the
+ * episodes of a configuration and by the threads running them. The map is split into shards
+ * protected by their own mutex, the shard of a key being given by its hash, so that
+ * concurrent lookups rarely contend. The size is bounded: once a shard is full, new
+ * decisions are not inserted. A decision is only inserted if its recommended action was
+ * visited at least 'min_visits' times.
+ */
+struct decision_cache {
+    static const unsigned NB_SHARDS = 64; ///< Number of shards
+
+    /** @brief Shard of the map */
+    struct shard {
+        std::mutex mtx; ///< Protects the entries
+        std::unordered_map<long long, decision_entry> entries; ///< Decisions of the shard
+    };
+
+    double quantum; ///< Quantization step of the states
+    size_t max_entries_per_shard; ///< Maximum number of entries of a shard
+    unsigned min_visits; ///< Minimum number of visits of the recommended action to insert a decision
+    std::vector<shard> shards; ///< Shards of the map
+    std::atomic<unsigned long long> nb_hits; ///< Number of lookups answered
+    std::atomic<unsigned long long> nb_misses; ///< Number of lookups not answered
+    std::atomic<unsigned long long> nb_rejected; ///< Number of decisions not inserted (full shard or not confident)
+
+    /**
+     * @brief Constructor
+     *
+     * @param {double} _quantum; quantization step of the states, positive
+     * @param {size_t} max_entries; maximum number of entries of the cache
+     * @param {unsigned} _min_visits; minimum number of visits of the recommended action
+     */
+    decision_cache(double _quantum, size_t max_entries, unsigned _min_visits) :
+        quantum(_quantum),
+        max_entries_per_shard((max_entries + NB_SHARDS - 1) / NB_SHARDS),
+        min_visits(_min_visits),
+        shards(NB_SHARDS),
+        nb_hits(0),
+        nb_misses(0),
+        nb_rejected(0)
+    {
+        for(auto &sh : shards) {
+            sh.entries.reserve(max_entries_per_shard);
+        }
+    }
+
+    decision_cache(const decision_cache &) = delete;
+    decision_cache & operator=(const decision_cache &) = delete;
+
+    /** @brief Get the key of a state */
+    long long get_key(double s) const {
+        return std::llround(s / quantum);
+    }
+
+    /** @brief Get the shard of a key */
+    shard & get_shard(long long key) {
+        return shards[std::hash<long long>()(key) % NB_SHARDS];
+    }
+
+    /**
+     * @brief Find a decision
+     *
+     * @param {double} s; state
+     * @param {decision_entry &} entry; decision at the quantized state, if any
+     * @return Return true if a decision was found.
+     */
+    bool find(double s, decision_entry &entry) {
+        long long key = get_key(s);
+        shard &sh = get_shard(key);
+        {
+            std::lock_guard<std::mutex> lock(sh.mtx);
+            auto it = sh.entries.find(key);
+            if(it != sh.entries.end()) {
+                entry = it->second;
+                ++nb_hits;
+                return true;
+            }
+        }
+        ++nb_misses;
+        return false;
+    }
+
+    /**
+     * @brief Insert a decision
+     *
+     * An existing decision at the same quantized state is kept.
+     * @param {double} s; state
+     * @param {const decision_entry &} entry; decision at this state
+     */
+    void insert(double s, const decision_entry &entry) {
+        if(entry.nb_visits < min_visits) {
+            ++nb_rejected;
+            return;
+        }
+        long long key = get_key(s);
+        shard &sh = get_shard(key);
+        std::lock_guard<std::mutex> lock(sh.mtx);
+        if(sh.entries.size() >= max_entries_per_shard) {
+            ++nb_rejected;
+            return;
+        }
+        sh.entries.emplace(key,entry);
+    }
+
+    /** @brief Get the number of entries */
+    size_t size() {
+        size_t nb_entries = 0;
+        for(auto &sh : shards) {
+            std::lock_guard<std::mutex> lock(sh.mtx);
+            nb_entries += sh.entries.size();
+        }
+        return nb_entries;
+    }
+
+    /** @brief Get the ratio of the lookups answered by the cache */
+    double get_hit_rate() const {
+        unsigned long long nb_lookups = nb_hits + nb_misses;
+        return (nb_lookups == 0) ? 0. : ((double) nb_hits) / ((double) nb_lookups);
+    }
+};
+
+#endif // DECISION_CACHE_HPP_
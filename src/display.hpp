@@ -4,11 +4,12 @@
 /**
  * @brief Print track
  *
- * Print a nice overview of the track with the agents position.
+ * Print a nice overview of the track with the agents position. Template method.
  * @param {track &} tr; reference to the track
- * @param {agent &} ag; reference to the agent
+ * @param {A &} ag; reference to the agent
  */
-void print_track(track &tr, agent &ag) {
+template <class A>
+void print_track(track &tr, A &ag) {
     double s = std::abs(ag.s);
     double m = tr.track_length / 10.;
     int pos = 0;
@@ -33,10 +34,12 @@ void print_track(track &tr, agent &ag) {
  * @brief Print
  *
  * Print some informations about the state, action and reward. Also print the track.
- * @param {track &} tr; reference to the track
- * @param {agent &} ag; reference to the agent
+ * Template method.
+ * @param {T &} tr; reference to the track
+ * @param {A &} ag; reference to the agent
  */
-void print(track &tr, agent &ag) {
+template <class T, class A>
+void print(T &tr, A &ag) {
     std::cout << "t:" << tr.time << " ";
     if(tr.time<10){std::cout << " ";}
     print_track(tr,ag);
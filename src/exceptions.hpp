@@ -15,6 +15,20 @@ struct wrong_nb_input_argument_exception : std::exception {
     }
 };
 
+/**
+ * @brief Wrong shard argument exception
+ *
+ * Exception for wrong shard argument in main function.
+ */
+struct wrong_shard_argument_exception : std::exception {
+    explicit wrong_shard_argument_exception() noexcept {}
+    virtual ~wrong_shard_argument_exception() noexcept {}
+
+    virtual const char * what() const noexcept override {
+        return "wrong shard argument (should be 'i/n' with i < n), see main function.\n";
+    }
+};
+
 /**
  * @brief Decision criterion selector exception
  *
@@ -57,4 +71,18 @@ struct wrong_syntax_configuration_file_exception : std::exception {
     }
 };
 
+/**
+ * @brief Output format exception
+ *
+ * Exception for unknown output format in configuration file.
+ */
+struct output_format_exception : std::exception {
+    explicit output_format_exception() noexcept {}
+    virtual ~output_format_exception() noexcept {}
+
+    virtual const char * what() const noexcept override {
+        return "in config file: unknown output format (should be \"csv\" or \"bin\").\n";
+    }
+};
+
 #endif // EXCEPTIONS_HPP_
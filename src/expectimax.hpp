@@ -0,0 +1,250 @@
+#ifndef EXPECTIMAX_HPP_
+#define EXPECTIMAX_HPP_
+
+#include <cmath>
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <model.hpp>
+#include <thread_pool.hpp>
+
+/**
+ * @brief Expectimax search
+ *
+ * Depth-limited expectimax over a generative model, alternative to the UCT trees for small
+ * action spaces. The values are those estimated by the trees: the value of a terminal state
+ * is its reward, the value of a state at the depth limit is the return of a rollout of the
+ * epsilon-optimal policy, and the value of any other state is its reward plus the discounted
+ * best expected value of its actions.
+ * If the model enumerates the outcomes of its transitions (see
+ * 'generative_model::transition_outcomes'), the expectations are exact and the values are
+ * memoized by (state, depth), so that a state reached by several paths is evaluated once.
+ * Otherwise, the expectations are estimated by sparse sampling: 'width' next states are
+ * sampled per action, down to a smaller depth since the cost grows as (nb_actions * width)
+ * to the power of the depth.
+ * With the symmetry folding, the memo is keyed by |s|: for a mirror symmetric model and
+ * action space, a state and its mirror have the same value.
+ * Template class, 'M' is the model.
+ */
+template <class M>
+struct expectimax_search {
+    /** @brief Key of the memo */
+    struct memo_key {
+        double s; ///< State
+        unsigned depth; ///< Remaining depth
+
+        bool operator==(const memo_key &other) const {
+            return s == other.s && depth == other.depth;
+        }
+    };
+
+    /** @brief Hash of a memo key */
+    struct memo_hash {
+        size_t operator()(const memo_key &k) const {
+            return std::hash<double>()(k.s) * 31 + k.depth;
+        }
+    };
+
+    M &m; ///< Model, its calls are counted
+    std::vector<int> action_space; ///< Action space
+    double discount_factor; ///< Discount factor
+    double epsilon; ///< Epsilon of the rollout policy
+    unsigned horizon; ///< Horizon of the rollouts
+    unsigned width; ///< Number of sampled next states per action (sparse sampling)
+    bool is_exact; ///< True if the model enumerates its outcomes
+    bool fold; ///< If true, the mirrored states share their memo entries
+    std::unordered_map<memo_key, double, memo_hash> memo; ///< Values by (state, depth)
+    std::vector<double> states_buffer; ///< Next states of each depth, 'get_stride()' per depth
+    std::vector<double> weights_buffer; ///< Weights of the next states of each depth
+    unsigned nb_memo_hits; ///< Number of values read in the memo
+
+    /**
+     * @brief Constructor
+     *
+     * @param {M &} _m; model
+     * @param {const std::vector<int> &} _action_space; action space
+     * @param {double} _discount_factor; discount factor
+     * @param {double} _epsilon; epsilon of the rollout policy
+     * @param {unsigned} _horizon; horizon of the rollouts
+     * @param {unsigned} _width; number of sampled next states per action (sparse sampling)
+     * @param {bool} _fold; if true, the mirrored states share their memo entries
+     */
+    expectimax_search(
+        M &_m,
+        const std::vector<int> &_action_space,
+        double _discount_factor,
+        double _epsilon,
+        unsigned _horizon,
+        unsigned _width,
+        bool _fold = false) :
+        m(_m),
+        action_space(_action_space),
+        discount_factor(_discount_factor),
+        epsilon(_epsilon),
+        horizon(_horizon),
+        width(std::max(_width,1u)),
+        fold(_fold),
+        nb_memo_hits(0)
+    {
+        double states[MAX_TRANSITION_OUTCOMES], probabilities[MAX_TRANSITION_OUTCOMES];
+        is_exact = (m.transition_outcomes(0.,action_space.at(0),states,probabilities) > 0);
+    }
+
+    /** @brief Get the maximum number of next states of a transition */
+    unsigned get_stride() const {
+        return std::max(width,MAX_TRANSITION_OUTCOMES);
+    }
+
+    /** @brief Reserve the next states buffers of a search of the given depth */
+    void reserve_buffers(unsigned depth) {
+        states_buffer.resize((size_t) (depth + 1) * get_stride());
+        weights_buffer.resize(states_buffer.size());
+    }
+
+    /**
+     * @brief Rollout
+     *
+     * Return of an episode of the epsilon-optimal policy starting at s, see
+     * 'basic_agent::default_policy'.
+     */
+    double rollout(double s) {
+        double total_return = 0.;
+        int a = epsilon_optimal_action(m,action_space,epsilon,s);
+        for(unsigned t=0; t<horizon; ++t) {
+            double s_p = m.transition_model(s,a);
+            total_return += pow(discount_factor,(double)t) * m.reward_model(s,a,s_p);
+            if(m.is_terminal(s)) { // Termination criterion
+                break;
+            }
+            s = s_p;
+            a = epsilon_optimal_action(m,action_space,epsilon,s);
+        }
+        return total_return;
+    }
+
+    /**
+     * @brief Next states
+     *
+     * Enumerate the outcomes of the transition (s,a), or sample 'width' of them with equal
+     * weights if the model does not enumerate them.
+     * @param {double *} states; next states, 'get_stride()' at most
+     * @param {double *} weights; weights of the next states
+     * @return Return the number of next states.
+     */
+    unsigned next_states(double s, int a, double *states, double *weights) {
+        if(is_exact) {
+            return m.enumerate_transitions(s,a,states,weights);
+        }
+        for(unsigned i=0; i<width; ++i) {
+            states[i] = m.transition_model(s,a);
+            weights[i] = 1. / (double) width;
+        }
+        return width;
+    }
+
+    /**
+     * @brief Value
+     *
+     * Value of a state with the given remaining depth, the buffers being reserved for this
+     * depth. Recursive method.
+     * @param {double} s; state
+     * @param {unsigned} depth; remaining depth
+     * @return Return the value of the state.
+     */
+    double value(double s, unsigned depth) {
+        if(m.is_terminal(s)) {
+            return m.reward_model(s,0,s);
+        }
+        if(depth == 0) {
+            return rollout(s);
+        }
+        memo_key key{fold ? std::fabs(s) : s,depth};
+        if(is_exact) {
+            auto it = memo.find(key);
+            if(it != memo.end()) {
+                ++nb_memo_hits;
+                return it->second;
+            }
+        }
+        double * states = states_buffer.data() + (size_t) depth * get_stride();
+        double * weights = weights_buffer.data() + (size_t) depth * get_stride();
+        double best_q = 0.;
+        for(unsigned i=0; i<action_space.size(); ++i) {
+            unsigned n = next_states(s,action_space[i],states,weights);
+            double q = 0.;
+            for(unsigned j=0; j<n; ++j) {
+                q += weights[j] * value(states[j],depth - 1);
+            }
+            if(i == 0 || q > best_q) {
+                best_q = q;
+            }
+        }
+        double v = m.reward_model(s,0,s) + discount_factor * best_q;
+        if(is_exact) {
+            memo[key] = v;
+        }
+        return v;
+    }
+
+    /**
+     * @brief Plan
+     *
+     * Compute the expected value of every action at a non-terminal state. The next states
+     * of the root are evaluated in parallel by the tasks of 'pool' if any, each task with its
+     * own search (memo and copy of the model), or sequentially with a shared memo otherwise.
+     * The calls of the tasks are added to those of the model of the search.
+     * @param {double} s; root state
+     * @param {unsigned} depth; depth of the search, at least 1
+     * @param {thread_pool *} pool; thread pool of the tasks, nullptr for a sequential search
+     * @param {std::vector<double> &} q_values; expected value of every action
+     */
+    void plan(double s, unsigned depth, thread_pool * pool, std::vector<double> &q_values) {
+        memo.clear();
+        reserve_buffers(depth);
+        std::vector<int> actions; // action indice of each root next state
+        std::vector<double> states, weights;
+        double * s_buffer = states_buffer.data() + (size_t) depth * get_stride();
+        double * w_buffer = weights_buffer.data() + (size_t) depth * get_stride();
+        for(unsigned i=0; i<action_space.size(); ++i) {
+            unsigned n = next_states(s,action_space[i],s_buffer,w_buffer);
+            for(unsigned j=0; j<n; ++j) {
+                actions.push_back((int) i);
+                states.push_back(s_buffer[j]);
+                weights.push_back(w_buffer[j]);
+            }
+        }
+        std::vector<double> values(states.size());
+        if(pool == nullptr) {
+            for(unsigned k=0; k<states.size(); ++k) {
+                values[k] = value(states[k],depth - 1);
+            }
+        } else {
+            std::vector<std::future<std::pair<double, unsigned>>> tasks;
+            for(unsigned k=0; k<states.size(); ++k) {
+                M task_model = m;
+                task_model.nb_calls = 0;
+                double s_k = states[k];
+                tasks.push_back(pool->submit([this,task_model,s_k,depth]() mutable {
+                    expectimax_search task_search(task_model,action_space,discount_factor,epsilon,horizon,width,fold);
+                    task_search.reserve_buffers(depth);
+                    double v = task_search.value(s_k,depth - 1);
+                    return std::make_pair(v,task_model.nb_calls);
+                }));
+            }
+            for(unsigned k=0; k<states.size(); ++k) {
+                std::pair<double, unsigned> result = tasks[k].get();
+                values[k] = result.first;
+                m.nb_calls += result.second;
+            }
+        }
+        q_values.assign(action_space.size(),0.);
+        for(unsigned k=0; k<states.size(); ++k) {
+            q_values[actions[k]] += weights[k] * values[k];
+        }
+    }
+};
+
+#endif // EXPECTIMAX_HPP_
@@ -0,0 +1,177 @@
+#ifndef JOURNAL_HPP_
+#define JOURNAL_HPP_
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+/**
+ * @brief Sweep journal
+ *
+ * Append-only journal of a sweep, used to resume it after a crash. Each completed episode is
+ * journaled with the key of its configuration (its output path), its indice and its saved
+ * values; each completed configuration is journaled as well. One record per line:
+ * - 'E<TAB>key<TAB>indice<TAB>v1,v2,...' for a completed episode;
+ * - 'C<TAB>key' for a completed configuration.
+ * A truncated last line (crash while writing) is ignored. At construction, the existing
+ * journal is loaded so that the finished configurations are skipped and the finished
+ * episodes of the interrupted configuration are reused instead of being run again.
+ */
+struct sweep_journal {
+    std::string path; ///< Journal path
+    std::FILE * file; ///< Journal file, opened in append mode
+    std::set<std::string> done_configurations; ///< Keys of the completed configurations
+    std::map<std::string, std::map<unsigned, std::vector<double>>> episodes; ///< Completed episodes of the uncompleted configurations
+
+    /**
+     * @brief Constructor
+     *
+     * Load the existing journal, if any, then open it in append mode.
+     * @param {const std::string &} _path; the journal path
+     */
+    explicit sweep_journal(const std::string &_path) : path(_path) {
+        bool needs_newline = load();
+        file = std::fopen(path.c_str(),"ab");
+        if(file == nullptr) {
+            throw std::runtime_error("cannot open journal file " + path);
+        }
+        if(needs_newline) { // terminate the truncated last line
+            std::fputc('\n',file);
+        }
+    }
+
+    /** @brief Destructor */
+    ~sweep_journal() {
+        std::fclose(file);
+    }
+
+    sweep_journal(const sweep_journal &) = delete;
+    sweep_journal & operator=(const sweep_journal &) = delete;
+
+    /**
+     * @brief Load the journal
+     *
+     * @return Return true if the journal does not end with a new line.
+     */
+    bool load() {
+        std::ifstream infile(path);
+        std::string line;
+        while(std::getline(infile,line)) {
+            if(infile.eof()) { // no new line: truncated record
+                return true;
+            }
+            parse_line(line);
+        }
+        return false;
+    }
+
+    /** @brief Parse a journal line, malformed lines are ignored */
+    void parse_line(const std::string &line) {
+        std::vector<std::string> fields;
+        size_t begin = 0, end = 0;
+        while((end = line.find('\t',begin)) != std::string::npos) {
+            fields.push_back(line.substr(begin,end - begin));
+            begin = end + 1;
+        }
+        fields.push_back(line.substr(begin));
+        if(fields.size() == 2 && fields[0] == "C") {
+            done_configurations.insert(fields[1]);
+            episodes.erase(fields[1]);
+        } else if(fields.size() == 4 && fields[0] == "E") {
+            std::vector<double> row;
+            const char * str = fields[3].c_str();
+            char * str_end = nullptr;
+            while(*str != '\0') {
+                row.push_back(std::strtod(str,&str_end));
+                if(str_end == str) {
+                    return;
+                }
+                str = (*str_end == ',') ? str_end + 1 : str_end;
+            }
+            episodes[fields[1]][(unsigned) std::strtoul(fields[2].c_str(),nullptr,10)] = row;
+        }
+    }
+
+    /** @brief Test if a configuration is completed */
+    bool is_done(const std::string &key) const {
+        return done_configurations.count(key) > 0;
+    }
+
+    /**
+     * @brief Find an episode
+     *
+     * @param {const std::string &} key; the configuration key
+     * @param {unsigned} indice; the episode indice
+     * @param {size_t} nb_values; the expected number of saved values
+     * @return Return a pointer to the saved values of the episode, nullptr if the episode is
+     * not journaled (or was saved with another number of values).
+     */
+    const std::vector<double> * find_episode(
+        const std::string &key,
+        unsigned indice,
+        size_t nb_values) const
+    {
+        auto conf = episodes.find(key);
+        if(conf == episodes.end()) {
+            return nullptr;
+        }
+        auto ep = conf->second.find(indice);
+        if(ep == conf->second.end() || ep->second.size() != nb_values) {
+            return nullptr;
+        }
+        return &ep->second;
+    }
+
+    /**
+     * @brief Record an episode
+     *
+     * The record is buffered until the next call to 'flush' or 'record_done'.
+     * @param {const std::string &} key; the configuration key, without tab nor new line
+     * @param {unsigned} indice; the episode indice
+     * @param {const std::vector<double> &} row; the saved values of the episode
+     */
+    void record_episode(const std::string &key, unsigned indice, const std::vector<double> &row) {
+        assert(key.find_first_of("\t\n") == std::string::npos);
+        std::string line = "E\t" + key + "\t" + std::to_string(indice) + "\t";
+        char buffer[32];
+        for(unsigned i=0; i<row.size(); ++i) {
+            line.append(buffer,std::snprintf(buffer,32,"%.17g",row[i])); // lossless
+            if(i<row.size()-1) {
+                line += ',';
+            }
+        }
+        line += '\n';
+        std::fwrite(line.data(),1,line.size(),file);
+    }
+
+    /** @brief Flush the buffered records to the operating system */
+    void flush() {
+        std::fflush(file);
+    }
+
+    /**
+     * @brief Record a completed configuration
+     *
+     * The journal is flushed and synchronized with the disk.
+     * @param {const std::string &} key; the configuration key
+     */
+    void record_done(const std::string &key) {
+        assert(key.find_first_of("\t\n") == std::string::npos);
+        std::string line = "C\t" + key + "\n";
+        std::fwrite(line.data(),1,line.size(),file);
+        std::fflush(file);
+        fsync(fileno(file));
+        done_configurations.insert(key);
+        episodes.erase(key);
+    }
+};
+
+#endif // JOURNAL_HPP_
@@ -7,14 +7,15 @@
  * @brief Scalar mean estimator
  *
  * Compute the mean estimator of the input scalar data set.
- * This method is implemented for 1 dimension.
- * @param {std::vector<double> &} data; input data set
+ * This method is implemented for 1 dimension. Template method over the container.
+ * @param {const C &} data; input data set
  * @return Return the estimator of the mean scalar of the input data set.
  */
-double mean1d_estimator(std::vector<double> &data) {
+template <class C>
+double mean1d_estimator(const C &data) {
 	assert(data.size() > 0);
 	double m = 0.;
-	for(auto &v : data) {
+	for(auto v : data) {
 		m += v;
 	}
 	m /= ((double) data.size());
@@ -25,21 +26,22 @@ double mean1d_estimator(std::vector<double> &data) {
  * @brief Scalar variance estimator
  *
  * Compute the variance estimator of the input data set.
- * This method is implemented for 1 dimension.
+ * This method is implemented for 1 dimension. Template method over the container.
  * Mean vector is given as an argument for faster computation in case it would
  * already have been calculated.
- * @param {std::vector<double> &} data; input scalar data set
+ * @param {const C &} data; input scalar data set
  * @param {double} mean; mean of the distribution or estimator
  * @return Return the variance estimator of the input data set.
  */
+template <class C>
 double var1d_estimator(
-	std::vector<double> &data,
+	const C &data,
 	double mean)
 {
 	assert(data.size() > 0);
 	double var = 0.;
 	if(data.size() > 1) {
-		for(auto &v : data) {
+		for(auto v : data) {
 			var += pow(v-mean,2.);
 		}
 		var /= ((double) data.size());
@@ -51,11 +53,12 @@ double var1d_estimator(
  * @brief Scalar variance estimator
  *
  * Compute the variance estimator of the input data set.
- * This method is implemented for 1 dimension.
- * @param {std::vector<double> &} data; input data set
+ * This method is implemented for 1 dimension. Template method over the container.
+ * @param {const C &} data; input data set
  * @return Return the variance estimator of the input data set.
  */
-double var1d_estimator(std::vector<double> &data) {
+template <class C>
+double var1d_estimator(const C &data) {
 	double mean = mean1d_estimator(data);
 	return var1d_estimator(data,mean);
 }
@@ -97,12 +100,13 @@ double mahalanobis1d_distance(
  * zero.
  * If the variance is zero, a 'big' value is returned.
  * @param {double} v; input scalar
- * @param {std::vector<double> &} data; input scalar data set
+ * @param {const C &} data; input scalar data set
  * @return Return the 1D Mahalanobis distance.
  */
+template <class C>
 double mahalanobis1d_distance(
 	double v,
-	std::vector<double> &data,
+	const C &data,
 	double precision = 1e-30)
 {
 	double mean = mean1d_estimator(data);
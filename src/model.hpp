@@ -0,0 +1,480 @@
+#ifndef MODEL_HPP_
+#define MODEL_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+constexpr unsigned MAX_TRANSITION_OUTCOMES = 4; ///< Maximum number of enumerated outcomes of a transition
+
+/**
+ * @brief Generative model interface
+ *
+ * CRTP base class of every generative model used by the agent. The calls are resolved at
+ * compile time hence using a model through this interface costs nothing compared to calling
+ * a concrete model directly (no virtual call).
+ * A model 'M' should derive from 'generative_model<M>' and implement the following methods:
+ * - 'double sample_transition(double s, int a)'; sample a next state;
+ * - 'double reward_model(double s, int a, double s_p)'; reward of the transition;
+ * - 'bool is_terminal(double s)'; terminal state test;
+ * - 'double failure_probability_at(double s)'; probability with which the opposite action
+ * effect is applied at state s (used by the epsilon-optimal policy).
+ * Optionally, 'void sample_transition_batch(const double *, const int *, double *, unsigned)'
+ * can be overridden by vectorized models, the default implementation loops over
+ * 'sample_transition'; 'exact_states' can be set to true by the models whose states are
+ * exactly represented, so that the agent compares them without tolerance; 'mirror_symmetric'
+ * can be set to true by the models invariant by the mirroring (s,a) -> (-s,-a), whose
+ * rewards and terminal states only depend on |s|, so that the planning may fold the mirrored
+ * states (see 'parameters::SYMMETRY_FOLDING'); and
+ * 'unsigned transition_outcomes(double s, int a, double *states, double *probabilities)' can
+ * be overridden by the models with finitely many outcomes (at most 'MAX_TRANSITION_OUTCOMES')
+ * to enumerate them, either at every state or at none; by default, the outcomes are not
+ * enumerated and the expectimax policy samples them.
+ */
+template <class M>
+struct generative_model {
+    static constexpr bool exact_states = false; ///< If true, the states are compared exactly
+    static constexpr bool mirror_symmetric = false; ///< If true, the model is invariant by mirroring
+    unsigned nb_calls; ///< Tracked number of calls to the model
+
+    /** @brief Constructor */
+    generative_model() : nb_calls(0) {}
+
+    /** @brief Static cast to the implementation */
+    M & derived() {return *static_cast<M *>(this);}
+
+    /**
+     * @brief Transition model
+     *
+     * Simulate a state transition wrt the models parameters and count the call.
+     * @param {double} s; state
+     * @param {int} a; action
+     * @return Return the resulting state
+     */
+    double transition_model(double s, int a) {
+        nb_calls++;
+        return derived().sample_transition(s,a);
+    }
+
+    /**
+     * @brief Batch transition model
+     *
+     * Simulate n state transitions at once, each call being counted.
+     * @param {const double *} s; array of n states
+     * @param {const int *} a; array of n actions
+     * @param {double *} s_p; array of n resulting states
+     * @param {unsigned} n; number of transitions
+     */
+    void transition_model_batch(const double *s, const int *a, double *s_p, unsigned n) {
+        nb_calls += n;
+        derived().sample_transition_batch(s,a,s_p,n);
+    }
+
+    /**
+     * @brief Enumerate transitions
+     *
+     * Enumerate the outcomes of the transition (s,a) with their probabilities, counted as a
+     * single call.
+     * @param {double} s; state
+     * @param {int} a; action
+     * @param {double *} states; resulting states, 'MAX_TRANSITION_OUTCOMES' at most
+     * @param {double *} probabilities; probabilities of the resulting states
+     * @return Return the number of outcomes, 0 if the model does not enumerate them.
+     */
+    unsigned enumerate_transitions(double s, int a, double *states, double *probabilities) {
+        nb_calls++;
+        return derived().transition_outcomes(s,a,states,probabilities);
+    }
+
+    /**
+     * @brief Default transition outcomes
+     *
+     * The outcomes are not enumerated.
+     */
+    unsigned transition_outcomes(double s, int a, double *states, double *probabilities) {
+        (void) s; (void) a; (void) states; (void) probabilities;
+        return 0;
+    }
+
+    /**
+     * @brief Default batch sampling
+     *
+     * Loop over the single transition sampling method of the implementation.
+     */
+    void sample_transition_batch(const double *s, const int *a, double *s_p, unsigned n) {
+        for(unsigned i=0; i<n; ++i) {
+            s_p[i] = derived().sample_transition(s[i],a[i]);
+        }
+    }
+};
+
+/**
+ * @brief Epsilon optimal action
+ *
+ * Action of the epsilon-optimal policy of a model: move away from the center of the track
+ * (towards the closest end) with the largest action, or in the opposite direction if the
+ * failure is more likely than the success; with probability 'epsilon', act randomly without
+ * excluding the optimal action. Template method.
+ * @param {M &} m; model
+ * @param {const std::vector<int> &} action_space; action space
+ * @param {double} epsilon; probability of a random action
+ * @param {double} s; input state
+ * @return Return the epsilon-optimal action.
+ */
+template <class M>
+int epsilon_optimal_action(M &m, const std::vector<int> &action_space, double epsilon, double s) {
+    if(is_less_than(uniform_double(0.,1.),epsilon)) { // random action
+        return rand_element(action_space);
+    } else { // optimal action
+        int sgn = ((int)sign(s));
+        if(!is_less_than(m.failure_probability_at(s),.5)) {
+            sgn *= -1;
+        }
+        int mgn = (*std::max_element(action_space.begin(),action_space.end()));
+        return sgn * mgn;
+    }
+}
+
+/**
+ * @brief Mirror symmetric action space test
+ *
+ * @param {const std::vector<int> &} action_space; action space
+ * @return Return true if the opposite of every action is an action.
+ */
+inline bool is_mirror_symmetric(const std::vector<int> &action_space) {
+    for(auto a : action_space) {
+        if(std::find(action_space.begin(),action_space.end(),-a) == action_space.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Model of the environment
+ *
+ * Class including the methods able to simulate the states transitions of the environment
+ * and the reward function. The accuracy of the model is set with the simulation parameters.
+ * This is the model matching the dynamics of the 'track' environment.
+ */
+struct model : generative_model<model> {
+    static constexpr bool mirror_symmetric = true; ///< The dynamics and rewards only depend on |s|
+    double model_track_length; ///< Model length of the track (half of the length)
+    double model_stddev; ///< Model noise standard deviation
+    double model_failure_probability; ///< Probability with chich the oposite action effect is applied in the model (randomness of the transition function)
+
+    /** @brief Constructor */
+    model(
+        double _model_track_length,
+        double _model_stddev,
+        double _model_failure_probability) :
+        model_track_length(_model_track_length),
+        model_stddev(_model_stddev),
+        model_failure_probability(_model_failure_probability)
+    {}
+
+    /**
+     * @brief Sample transition
+     *
+     * Sample a state transition wrt the models parameters.
+     * @param {double} s; state
+     * @param {int} a; action
+     * @return Return the resulting state
+     */
+    double sample_transition(double s, int a) {
+        double action_effect = (double) a;
+        if(is_less_than(uniform_double(0.,1.),model_failure_probability)) {
+            action_effect *= (-1.);
+        }
+        return s + action_effect + normal_double(0.,model_stddev);
+    }
+
+    /**
+     * @brief Transition outcomes
+     *
+     * Without noise, the outcomes are the action effect and the opposite one.
+     * @return Return the number of outcomes, 0 if the model is noisy.
+     */
+    unsigned transition_outcomes(double s, int a, double *states, double *probabilities) {
+        if(model_stddev != 0.) {
+            return 0;
+        }
+        states[0] = s + (double) a;
+        probabilities[0] = 1. - model_failure_probability;
+        states[1] = s - (double) a;
+        probabilities[1] = model_failure_probability;
+        return (model_failure_probability > 0.) ? 2 : 1;
+    }
+
+    /**
+     * @brief Reward model
+     *
+     * Reward model of the transition (s,a,s_p)
+     * @param {double} s; state
+     * @param {int} a; action
+     * @param {double} s_p; next state
+     * @return Return the resulting reward
+     */
+    double reward_model(double s, int a, double s_p) {
+        (void) a; (void) s_p; //default
+        return is_less_than(std::abs(s),model_track_length) ? 0. : 1.;
+    }
+
+    /**
+     * @brief Terminal state test
+     *
+     * Test if the state is terminal.
+     * @param {double} s; tested state
+     * @return Return 'true' if terminal
+     */
+    bool is_terminal(double s) {
+        return !is_less_than(std::fabs(s),model_track_length);
+    }
+
+    /** @brief Failure probability, independent of the state */
+    double failure_probability_at(double s) {
+        (void) s;
+        return model_failure_probability;
+    }
+};
+
+/**
+ * @brief Discrete model
+ *
+ * Noise-free specialization of 'model' (null 'model_stddev'). From an integer state, every
+ * reachable state is an integer, exactly represented by a double: no noise is sampled, the
+ * failure is only sampled if its probability is positive and the states are compared exactly.
+ */
+struct discrete_model : generative_model<discrete_model> {
+    static constexpr bool exact_states = true; ///< The states are integers
+    static constexpr bool mirror_symmetric = true; ///< The dynamics and rewards only depend on |s|
+    double model_track_length; ///< Model length of the track (half of the length)
+    double model_failure_probability; ///< Probability with which the opposite action effect is applied in the model
+
+    /** @brief Constructor */
+    discrete_model(
+        double _model_track_length,
+        double _model_failure_probability) :
+        model_track_length(_model_track_length),
+        model_failure_probability(_model_failure_probability)
+    {}
+
+    /** @brief Sample transition, see 'model::sample_transition' */
+    double sample_transition(double s, int a) {
+        if(model_failure_probability > 0. && uniform_double(0.,1.) < model_failure_probability) {
+            return s - (double) a;
+        }
+        return s + (double) a;
+    }
+
+    /** @brief Transition outcomes: the action effect and the opposite one */
+    unsigned transition_outcomes(double s, int a, double *states, double *probabilities) {
+        states[0] = s + (double) a;
+        probabilities[0] = 1. - model_failure_probability;
+        states[1] = s - (double) a;
+        probabilities[1] = model_failure_probability;
+        return (model_failure_probability > 0.) ? 2 : 1;
+    }
+
+    /** @brief Reward model, see 'model::reward_model' */
+    double reward_model(double s, int a, double s_p) {
+        (void) a; (void) s_p; //default
+        return (std::fabs(s) < model_track_length) ? 0. : 1.;
+    }
+
+    /** @brief Terminal state test, see 'model::is_terminal' */
+    bool is_terminal(double s) {
+        return !(std::fabs(s) < model_track_length);
+    }
+
+    /** @brief Failure probability, independent of the state */
+    double failure_probability_at(double s) {
+        (void) s;
+        return model_failure_probability;
+    }
+};
+
+/**
+ * @brief State-dependent failure model
+ *
+ * Same as 'model' except that the failure probability is linearly interpolated between
+ * its value at the center of the track and its value at the edges.
+ */
+struct state_dependent_failure_model : generative_model<state_dependent_failure_model> {
+    static constexpr bool mirror_symmetric = true; ///< The failure probability only depends on |s|
+    double model_track_length; ///< Model length of the track (half of the length)
+    double model_stddev; ///< Model noise standard deviation
+    double center_failure_probability; ///< Failure probability at s = 0
+    double edge_failure_probability; ///< Failure probability at |s| = model_track_length
+
+    /** @brief Constructor */
+    state_dependent_failure_model(
+        double _model_track_length,
+        double _model_stddev,
+        double _center_failure_probability,
+        double _edge_failure_probability) :
+        model_track_length(_model_track_length),
+        model_stddev(_model_stddev),
+        center_failure_probability(_center_failure_probability),
+        edge_failure_probability(_edge_failure_probability)
+    {}
+
+    /** @brief Failure probability at state s */
+    double failure_probability_at(double s) {
+        double ratio = std::min(std::fabs(s) / model_track_length,1.);
+        return center_failure_probability +
+            ratio * (edge_failure_probability - center_failure_probability);
+    }
+
+    /** @brief Sample transition, see 'model::sample_transition' */
+    double sample_transition(double s, int a) {
+        double action_effect = (double) a;
+        if(is_less_than(uniform_double(0.,1.),failure_probability_at(s))) {
+            action_effect *= (-1.);
+        }
+        return s + action_effect + normal_double(0.,model_stddev);
+    }
+
+    /** @brief Reward model, see 'model::reward_model' */
+    double reward_model(double s, int a, double s_p) {
+        (void) a; (void) s_p; //default
+        return is_less_than(std::abs(s),model_track_length) ? 0. : 1.;
+    }
+
+    /** @brief Terminal state test, see 'model::is_terminal' */
+    bool is_terminal(double s) {
+        return !is_less_than(std::fabs(s),model_track_length);
+    }
+};
+
+/**
+ * @brief Asymmetric reward model
+ *
+ * Same dynamics as 'model' but reaching each end of the track yields a different reward.
+ */
+struct asymmetric_reward_model : generative_model<asymmetric_reward_model> {
+    double model_track_length; ///< Model length of the track (half of the length)
+    double model_stddev; ///< Model noise standard deviation
+    double model_failure_probability; ///< Probability with chich the oposite action effect is applied in the model
+    double left_reward; ///< Reward for reaching the negative end of the track
+    double right_reward; ///< Reward for reaching the positive end of the track
+
+    /** @brief Constructor */
+    asymmetric_reward_model(
+        double _model_track_length,
+        double _model_stddev,
+        double _model_failure_probability,
+        double _left_reward,
+        double _right_reward) :
+        model_track_length(_model_track_length),
+        model_stddev(_model_stddev),
+        model_failure_probability(_model_failure_probability),
+        left_reward(_left_reward),
+        right_reward(_right_reward)
+    {}
+
+    /** @brief Sample transition, see 'model::sample_transition' */
+    double sample_transition(double s, int a) {
+        double action_effect = (double) a;
+        if(is_less_than(uniform_double(0.,1.),model_failure_probability)) {
+            action_effect *= (-1.);
+        }
+        return s + action_effect + normal_double(0.,model_stddev);
+    }
+
+    /** @brief Reward model, the reward depends on the reached end of the track */
+    double reward_model(double s, int a, double s_p) {
+        (void) a; (void) s_p; //default
+        if(is_less_than(std::abs(s),model_track_length)) {
+            return 0.;
+        }
+        return is_less_than(s,0.) ? left_reward : right_reward;
+    }
+
+    /** @brief Terminal state test, see 'model::is_terminal' */
+    bool is_terminal(double s) {
+        return !is_less_than(std::fabs(s),model_track_length);
+    }
+
+    /** @brief Failure probability, independent of the state */
+    double failure_probability_at(double s) {
+        (void) s;
+        return model_failure_probability;
+    }
+};
+
+/**
+ * @brief Learned tabular model
+ *
+ * Model learned from observed transitions. The state space is discretized into bins of
+ * width 'bin_width' and the observed displacements are stored for each (bin, action) pair.
+ * A transition is sampled among the recorded displacements of its pair; the nominal
+ * dynamics of 'model' are used for pairs that have not been observed yet.
+ */
+struct tabular_model : generative_model<tabular_model> {
+    model prior; ///< Nominal model used for unobserved pairs
+    double bin_width; ///< Width of a state bin
+    std::map<std::pair<int,int>, std::vector<double>> displacements; ///< Observed displacements
+
+    /** @brief Constructor */
+    tabular_model(const model &_prior, double _bin_width = 1.) :
+        prior(_prior),
+        bin_width(_bin_width)
+    {}
+
+    /** @brief Get the key of the (s,a) pair */
+    std::pair<int,int> key(double s, int a) const {
+        return std::make_pair((int) std::floor(s / bin_width + .5), a);
+    }
+
+    /**
+     * @brief Observe
+     *
+     * Record an observed transition (s,a,s_p).
+     */
+    void observe(double s, int a, double s_p) {
+        displacements[key(s,a)].push_back(s_p - s);
+    }
+
+    /** @brief Sample transition among the recorded displacements */
+    double sample_transition(double s, int a) {
+        auto it = displacements.find(key(s,a));
+        if(it == displacements.end() || it->second.empty()) {
+            return prior.sample_transition(s,a);
+        }
+        return s + rand_element(it->second);
+    }
+
+    /** @brief Reward model of the prior */
+    double reward_model(double s, int a, double s_p) {
+        return prior.reward_model(s,a,s_p);
+    }
+
+    /** @brief Terminal state test of the prior */
+    bool is_terminal(double s) {
+        return prior.is_terminal(s);
+    }
+
+    /** @brief Empirical failure probability at state s */
+    double failure_probability_at(double s) {
+        unsigned nb_obs = 0, nb_fail = 0;
+        for(int a : {-1,1}) {
+            auto it = displacements.find(key(s,a));
+            if(it == displacements.end()) {continue;}
+            for(auto &d : it->second) {
+                ++nb_obs;
+                if(is_less_than(d * (double) a,0.)) {++nb_fail;}
+            }
+        }
+        if(nb_obs == 0) {
+            return prior.failure_probability_at(s);
+        }
+        return ((double) nb_fail) / ((double) nb_obs);
+    }
+};
+
+#endif // MODEL_HPP_
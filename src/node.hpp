@@ -1,6 +1,11 @@
 #ifndef NODE_HPP_
 #define NODE_HPP_
 
+#include <small_vector.hpp>
+
+struct node_pool;
+inline node_pool & local_node_pool();
+
 /**
  * @brief Node class
  *
@@ -9,11 +14,13 @@
 struct node {
 private :
     bool root; ///< True if the node is root i.e. labeled by a unique state instead of a family of states
-    std::vector<double> sampled_outcomes; ///< Value function estimate
+    small_vector<double,4> sampled_outcomes; ///< Value function estimate
+    double outcomes_sum; ///< Sum of the sampled outcomes, kept when the history is compacted
+    double outcomes_sq_sum; ///< Sum of the squared sampled outcomes
     int incoming_action; ///< Action of the parent node that led to this node
     unsigned visits_count; ///< Number of visits during the tree expansion
     double state; ///<Unique labelling state for a root node
-    std::vector<double> sampled_states; ///< Sampled states for a standard node
+    small_vector<double,2> sampled_states; ///< Sampled states for a standard node
     std::vector<int> local_action_space; ///< Possible actions at this node (bandit arms)
 
 public :
@@ -30,6 +37,8 @@ public :
      */
     node(double _state, std::vector<int> _local_action_space) : state(_state) {
         root = true;
+        outcomes_sum = 0.;
+        outcomes_sq_sum = 0.;
         local_action_space = _local_action_space;
         shuffle(local_action_space);
         visits_count = 0;
@@ -51,30 +60,69 @@ public :
         parent(_parent)
     {
         root = false;
+        state = 0.;
         visits_count = 0;
+        outcomes_sum = 0.;
+        outcomes_sq_sum = 0.;
         sampled_states.push_back(_new_state);
         local_action_space = _local_action_space;
         shuffle(local_action_space);
     }
 
     /**
-     * @brief Clear method
+     * @brief Reset method
      *
-     * Clear the sampled outcomes; the parent; the incoming action; the state/states; the visit count
-     * and the children vector of the node. Do not change the value of 'root' attribute,
-     * hence the status of the node. Do not clear actions vector, hence the available actions
-     * still remain in the same organisation order.
+     * Reset a recycled node as a standard node, see the standard node constructor. The
+     * allocated capacity of its vectors is kept, the children vector is reserved for every
+     * action so that expanding the node does not allocate.
      */
-    void clear_node() {
-        parent = nullptr;
-        incoming_action = 0;
+    void reset(
+        node * _parent,
+        int _incoming_action,
+        double _new_state,
+        const std::vector<int> &_local_action_space)
+    {
+        root = false;
         state = 0.;
+        parent = _parent;
+        incoming_action = _incoming_action;
         visits_count = 0;
+        outcomes_sum = 0.;
+        outcomes_sq_sum = 0.;
         sampled_outcomes.clear();
         sampled_states.clear();
-        children.clear();
+        sampled_states.push_back(_new_state);
+        local_action_space = _local_action_space;
+        shuffle(local_action_space);
+        if(children.capacity() < local_action_space.size()) {
+            children.reserve(local_action_space.size());
+        }
     }
 
+    /**
+     * @brief Release the samples
+     *
+     * Clear the sampled outcomes and states and give their spilled storage back to the sample
+     * arena, so that a recycled node does not keep the largest histories it ever held.
+     */
+    void release_samples() {
+        sampled_outcomes.clear();
+        sampled_outcomes.shrink_to_fit();
+        sampled_states.clear();
+        sampled_states.shrink_to_fit();
+    }
+
+    /**
+     * @brief Clear method
+     *
+     * Clear the sampled outcomes; the parent; the incoming action; the state/states; the visit count
+     * and the children vector of the node. Do not change the value of 'root' attribute,
+     * hence the status of the node. Do not clear actions vector, hence the available actions
+     * still remain in the same organisation order.
+     * The children are given back to the node pool of the thread.
+     */
+    void clear_node();
+
     /** @brief Get the number of children */
     unsigned get_nb_children() const {
         return children.size();
@@ -92,11 +140,21 @@ public :
 
     /** @brief Get the value of the node */
     double get_value() const {
-        double value = 0.;
-        for(auto &r : sampled_outcomes) {
-            value += r;
+        return outcomes_sum / ((double) visits_count);
+    }
+
+    /**
+     * @brief Get the variance of the sampled outcomes
+     *
+     * Computed with the outcomes sums hence still valid once the history is compacted.
+     */
+    double get_outcomes_variance() const {
+        if(visits_count < 2) {
+            return 0.;
         }
-        return value / ((double) visits_count);
+        double mean = get_value();
+        double var = outcomes_sq_sum / ((double) visits_count) - mean * mean;
+        return (var > 0.) ? var : 0.;
     }
 
     /** @brief Get the state of the node (root node) */
@@ -113,12 +171,17 @@ public :
 
     /** @brief Get a copy of the states vector of the node */
     std::vector<double> get_sampled_states() const {
+        return sampled_states.to_vector();
+    }
+
+    /** @brief Get the sampled states of the node without copy */
+    const small_vector<double,2> & get_sampled_states_view() const {
         return sampled_states;
     }
 
     /** @brief Get a copy of the sampled outcomes of the node */
     std::vector<double> get_sampled_outcomes() const {
-        return sampled_outcomes;
+        return sampled_outcomes.to_vector();
     }
 
     /** @brief Get a copy of the last sampled state among the states family (non-root node) */
@@ -188,9 +251,7 @@ public :
      * @param {int} inc_ac; incoming action of the new child
      * @param {double} new_state; first sampled state of the new child
      */
-    void create_child(int inc_ac, double new_state) {
-        children.emplace_back(node(this,inc_ac,new_state,local_action_space));
-    }
+    void create_child(int inc_ac, double new_state);
 
     /**
      * @brief Set state
@@ -233,8 +294,113 @@ public :
     void add_to_value(double r) {
         assert(!root);
         sampled_outcomes.push_back(r);
+        outcomes_sum += r;
+        outcomes_sq_sum += r * r;
     }
 
+    /**
+     * @brief Add virtual visits
+     *
+     * Add visits carrying a prior value without any sampled outcome, used to warm-start a
+     * rebuilt tree. Node should not be root.
+     * @param {unsigned} nb_visits; number of virtual visits
+     * @param {double} value; prior value of the visits
+     */
+    void add_virtual_visits(unsigned nb_visits, double value) {
+        assert(!root);
+        visits_count += nb_visits;
+        outcomes_sum += ((double) nb_visits) * value;
+        outcomes_sq_sum += ((double) nb_visits) * value * value;
+    }
+
+    /**
+     * @brief Get the number of nodes
+     *
+     * Recursive method.
+     * @return Return the number of nodes of the tree starting at this node (included).
+     */
+    unsigned get_nb_nodes() const {
+        unsigned nb = 1;
+        for(auto &ch : children) {
+            nb += ch.get_nb_nodes();
+        }
+        return nb;
+    }
+
+    /**
+     * @brief Get the memory footprint
+     *
+     * Recursive method. Account for the node itself, the allocated capacity of its vectors
+     * (the spilled storage for the small vectors) and its children.
+     * @return Return the number of bytes used by the tree starting at this node.
+     */
+    size_t get_memory_footprint() const {
+        size_t bytes = get_node_footprint();
+        for(auto &ch : children) {
+            bytes += ch.get_memory_footprint();
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief Get the node footprint
+     *
+     * @return Return the number of bytes used by the node itself, its children excluded
+     * (see 'get_memory_footprint').
+     */
+    size_t get_node_footprint() const {
+        size_t bytes = sizeof(node);
+        bytes += sampled_outcomes.spilled_bytes();
+        bytes += sampled_states.spilled_bytes();
+        bytes += local_action_space.capacity() * sizeof(int);
+        bytes += (children.capacity() - children.size()) * sizeof(node);
+        return bytes;
+    }
+
+    /**
+     * @brief Add the tree size
+     *
+     * Compute both 'get_nb_nodes' and 'get_memory_footprint' in a single walk of the tree.
+     * Recursive method.
+     * @param {unsigned &} nb_nodes; incremented by the number of nodes of the tree
+     * @param {size_t &} bytes; incremented by the memory footprint of the tree
+     */
+    void add_tree_size(unsigned &nb_nodes, size_t &bytes) const {
+        ++nb_nodes;
+        bytes += get_node_footprint();
+        for(auto &ch : children) {
+            ch.add_tree_size(nb_nodes,bytes);
+        }
+    }
+
+    /**
+     * @brief Compact history
+     *
+     * Keep only the last 'keep' sampled outcomes and states of the node, the outcomes
+     * being summarized by their sums. Hence the value and the outcomes variance of the
+     * node are unchanged while the state decision criteria only use the kept states.
+     * @param {unsigned} keep; number of kept samples, at least 1
+     */
+    void compact_history(unsigned keep) {
+        keep = std::max(keep,1u);
+        if(sampled_outcomes.size() > keep) {
+            sampled_outcomes.erase(sampled_outcomes.begin(),sampled_outcomes.end() - keep);
+            sampled_outcomes.shrink_to_fit();
+        }
+        if(sampled_states.size() > keep) {
+            sampled_states.erase(sampled_states.begin(),sampled_states.end() - keep);
+            sampled_states.shrink_to_fit();
+        }
+    }
+
+    /**
+     * @brief Collapse
+     *
+     * Prune the sub-tree below the node, the node keeps its statistics and becomes a leaf
+     * again, it will be expanded anew if the tree policy reaches it.
+     */
+    void collapse();
+
     /**
      * @brief Move to child
      *
@@ -243,19 +409,291 @@ public :
      * @param {unsigned} indice; indice of the moved child
      * @param {double} new_state; new labelling state
      */
-    void move_to_child(unsigned indice, double new_state) {
-        assert(is_root());
-        local_action_space = children[indice].get_actions();
-        sampled_states = children[indice].get_sampled_states();
-        visits_count = children[indice].get_visits_count();
-        sampled_outcomes = children[indice].get_sampled_outcomes();
-        auto tmp = std::move(children[indice].children); // Temporary variable to prevent from overwriting
-        for(auto &elt : tmp) {
-            elt.parent = this;
+    void move_to_child(unsigned indice, double new_state);
+
+    /**
+     * @brief Clone from
+     *
+     * Replace the node and its sub-tree with a deep copy of the given tree, whose nodes are
+     * taken from the node pool and whose parent pointers point into the copy. The source is
+     * only read, hence several threads may clone the same tree concurrently. The parent of
+     * the node is kept.
+     * @param {const node &} src; cloned tree
+     */
+    void clone_from(const node &src);
+
+    /**
+     * @brief Mirror
+     *
+     * Negate the states and the actions of the node and of its sub-tree, the result is the
+     * tree of the mirrored state for a mirror symmetric model. Recursive method.
+     */
+    void mirror() {
+        if(root) { // the labelling state is only set on a root
+            state = -state;
+        }
+        incoming_action = -incoming_action;
+        for(auto &s : sampled_states) {
+            s = -s;
+        }
+        for(auto &a : local_action_space) {
+            a = -a;
+        }
+        for(auto &ch : children) {
+            ch.mirror();
+        }
+    }
+
+    /**
+     * @brief Fold the actions
+     *
+     * Move the negative actions of a root node without children to the end of its actions
+     * vector, the other actions keep their shuffled order. Used at a state invariant by the
+     * mirroring, where the sub-tree of -a is the mirror of the one of a.
+     * @return Return the number of actions a >= 0, expanded first.
+     */
+    unsigned fold_actions();
+
+    /**
+     * @brief Unfold the actions
+     *
+     * For each child of a positive action a, add a mirrored copy of its sub-tree as the
+     * child of -a. The actions vector is reordered so that it still lists the actions of
+     * the children first.
+     */
+    void unfold_actions();
+};
+
+/**
+ * @brief Node pool
+ *
+ * Pool of recycled nodes. A released node keeps the allocated capacity of its vectors so
+ * that, in steady state, creating a node does not call the allocator; only the spilled
+ * storage of its samples goes back to the sample arena, where it is reused by the next
+ * spills, so that the footprint of the pooled nodes does not grow across the trees. Each thread owns a
+ * pool (see 'local_node_pool') which outlives the episodes. The counters count the pool
+ * misses and hits, not the heap allocations: a recycled node may still allocate if its
+ * vectors are too small, e.g. for a larger action space or more sampled states than their
+ * inline capacity.
+ */
+struct node_pool {
+    std::vector<node> free_nodes; ///< Recycled nodes
+    unsigned nb_misses; ///< Number of nodes created because the pool was empty
+    unsigned nb_recycled; ///< Number of nodes taken from the pool
+
+    /** @brief Constructor */
+    node_pool() : nb_misses(0), nb_recycled(0) {}
+
+    /**
+     * @brief Acquire a node
+     *
+     * Get a standard node from the pool, or create it if the pool is empty. In both cases,
+     * the children vector of the node is reserved for every action.
+     * See the standard node constructor for the arguments.
+     * @return Return the node, to be moved into the children vector of its parent
+     */
+    node acquire(
+        node * _parent,
+        int _incoming_action,
+        double _new_state,
+        const std::vector<int> &_local_action_space)
+    {
+        if(free_nodes.empty()) {
+            ++nb_misses;
+            node v(_parent,_incoming_action,_new_state,_local_action_space);
+            v.children.reserve(_local_action_space.size());
+            return v;
+        }
+        ++nb_recycled;
+        node v = std::move(free_nodes.back());
+        free_nodes.pop_back();
+        v.reset(_parent,_incoming_action,_new_state,_local_action_space);
+        return v;
+    }
+
+    /**
+     * @brief Release a node
+     *
+     * Give a node and its whole sub-tree back to the pool. Recursive method.
+     * @param {node &} v; released node, left empty
+     */
+    void release(node &v) {
+        release_children(v);
+        v.release_samples();
+        free_nodes.push_back(std::move(v));
+    }
+
+    /**
+     * @brief Release the children of a node
+     *
+     * Give the sub-trees of the children of the node back to the pool, the capacity of
+     * the children vector is kept.
+     * @param {node &} v; node whose children are released
+     */
+    void release_children(node &v) {
+        for(auto &ch : v.children) {
+            release(ch);
         }
-        children = std::move(tmp);
-        state = new_state;
+        v.children.clear();
+    }
+
+    /**
+     * @brief Reserve
+     *
+     * Fill the pool with recycled nodes whose vectors are reserved for the given action
+     * space, so that the next 'nb_nodes' acquisitions do not allocate.
+     * @param {unsigned} nb_nodes; number of nodes available in the pool after the call
+     * @param {const std::vector<int> &} action_space; action space of the nodes
+     */
+    void reserve(unsigned nb_nodes, const std::vector<int> &action_space) {
+        free_nodes.reserve(std::max((size_t) 2 * nb_nodes,free_nodes.capacity()));
+        while(free_nodes.size() < nb_nodes) {
+            node v(nullptr,0,0.,action_space);
+            v.children.reserve(action_space.size());
+            free_nodes.push_back(std::move(v));
+        }
+    }
+
+    /**
+     * @brief Transfer
+     *
+     * Take free nodes from another pool until this pool holds 'nb_nodes' of them, or until the
+     * other pool is empty. The other pool should not be used concurrently.
+     * @param {node_pool &} other; pool giving its nodes
+     * @param {unsigned} nb_nodes; number of free nodes wanted in this pool
+     */
+    void transfer(node_pool &other, unsigned nb_nodes) {
+        while(free_nodes.size() < nb_nodes && !other.free_nodes.empty()) {
+            free_nodes.push_back(std::move(other.free_nodes.back()));
+            other.free_nodes.pop_back();
+        }
+    }
+
+    /** @brief Reset the misses and recycling counters */
+    void reset_counters() {
+        nb_misses = 0;
+        nb_recycled = 0;
     }
 };
 
+/**
+ * @brief Local node pool
+ *
+ * @return Return the node pool of the calling thread.
+ */
+inline node_pool & local_node_pool() {
+    static thread_local node_pool pool;
+    return pool;
+}
+
+/** @brief Clear method, the children are given back to the node pool */
+inline void node::clear_node() {
+    parent = nullptr;
+    incoming_action = 0;
+    state = 0.;
+    visits_count = 0;
+    outcomes_sum = 0.;
+    outcomes_sq_sum = 0.;
+    sampled_outcomes.clear();
+    sampled_states.clear();
+    local_node_pool().release_children(*this);
+}
+
+/**
+ * @brief Create a child
+ *
+ * The node is taken from the node pool and the children vector is reserved for every
+ * action so that the children never move.
+ */
+inline void node::create_child(int inc_ac, double new_state) {
+    if(children.capacity() < local_action_space.size()) {
+        children.reserve(local_action_space.size());
+    }
+    children.emplace_back(local_node_pool().acquire(this,inc_ac,new_state,local_action_space));
+}
+
+/** @brief Collapse, the sub-tree is given back to the node pool */
+inline void node::collapse() {
+    local_node_pool().release_children(*this);
+}
+
+/** @brief Clone from, the nodes of the copy are taken from the node pool */
+inline void node::clone_from(const node &src) {
+    node_pool &pool = local_node_pool();
+    pool.release_children(*this);
+    root = src.root;
+    sampled_outcomes = src.sampled_outcomes;
+    outcomes_sum = src.outcomes_sum;
+    outcomes_sq_sum = src.outcomes_sq_sum;
+    incoming_action = src.incoming_action;
+    visits_count = src.visits_count;
+    state = src.state;
+    sampled_states = src.sampled_states;
+    local_action_space = src.local_action_space;
+    if(children.capacity() < local_action_space.size()) { // the children never move
+        children.reserve(local_action_space.size());
+    }
+    for(auto &ch : src.children) {
+        children.emplace_back(pool.acquire(this,ch.incoming_action,0.,ch.local_action_space));
+        children.back().clone_from(ch);
+    }
+}
+
+/** @brief Fold the actions, stable partition of the actions vector */
+inline unsigned node::fold_actions() {
+    assert(root && children.empty());
+    auto it = std::stable_partition(local_action_space.begin(),local_action_space.end(),[](int a) {return a >= 0;});
+    return (unsigned) (it - local_action_space.begin());
+}
+
+/** @brief Unfold the actions, the mirrored nodes are taken from the node pool */
+inline void node::unfold_actions() {
+    assert(root);
+    node_pool &pool = local_node_pool();
+    if(children.capacity() < local_action_space.size()) { // the children never move
+        children.reserve(local_action_space.size());
+    }
+    unsigned nb_expanded = children.size();
+    for(unsigned i=0; i<nb_expanded; ++i) {
+        int a = children[i].incoming_action;
+        if(a > 0) {
+            auto first = local_action_space.begin() + children.size();
+            auto it = std::find(first,local_action_space.end(),-a);
+            std::rotate(first,it,it+1);
+            children.emplace_back(pool.acquire(this,-a,0.,children[i].local_action_space));
+            children.back().clone_from(children[i]);
+            children.back().mirror();
+        }
+    }
+}
+
+/** @brief Move to child, the other children are given back to the node pool */
+inline void node::move_to_child(unsigned indice, double new_state) {
+    assert(is_root());
+    std::vector<node> siblings; // Temporary variable to prevent from overwriting
+    siblings.swap(children);
+    node &ch = siblings[indice];
+    local_action_space = ch.local_action_space;
+    sampled_states = ch.sampled_states;
+    visits_count = ch.get_visits_count();
+    sampled_outcomes = ch.sampled_outcomes;
+    outcomes_sum = ch.outcomes_sum;
+    outcomes_sq_sum = ch.outcomes_sq_sum;
+    children.swap(ch.children);
+    for(auto &elt : children) {
+        elt.parent = this;
+    }
+    node_pool &pool = local_node_pool();
+    pool.release(ch);
+    size_t recycled_child = pool.free_nodes.size() - 1;
+    for(unsigned i=0; i<siblings.size(); ++i) {
+        if(i != indice) {
+            pool.release(siblings[i]);
+        }
+    }
+    siblings.clear(); // the storage of the root children is kept by the recycled child
+    pool.free_nodes[recycled_child].children.swap(siblings);
+    state = new_state;
+}
+
 #endif // NODE_HPP_
@@ -0,0 +1,52 @@
+#ifndef OPENING_HPP_
+#define OPENING_HPP_
+
+#include <parameters.hpp>
+#include <agent.hpp>
+
+/**
+ * @brief Opening cache
+ *
+ * Tree built once per configuration from the initial state with the opening budget, shared
+ * read-only by the episodes of the configuration: each episode starts with a clone of this
+ * tree (see 'basic_agent::load_opening') instead of building its first tree. With OLUCT, the
+ * sub-trees of the opening are then reused by the next decisions as long as the decision
+ * criteria keep them. The model calls spent to build the opening are counted in 'nb_calls'
+ * of the cache, not in those of the episodes.
+ */
+struct opening_cache {
+    node tree; ///< Opening tree, read-only once built
+    unsigned nb_calls; ///< Number of calls to the model spent to build the tree
+
+    /**
+     * @brief Constructor
+     *
+     * Build the opening tree with the policy parameters of the configuration and a budget
+     * of 'sp.OPENING_BUDGET'.
+     * @param {parameters &} sp; parameters of the configuration
+     * @param {unsigned long long} seed; seed of the build, the random engine of the thread is
+     * left as is if 0
+     */
+    opening_cache(parameters &sp, unsigned long long seed = 0) : tree(sp.INIT_S,sp.ACTION_SPACE) {
+        if(seed != 0) {
+            set_random_seed(seed);
+        }
+        policy_parameters p(sp);
+        p.budget = sp.OPENING_BUDGET;
+        agent builder(sp.INIT_S,p,model(sp.MODEL_TRACK_LEN,sp.MODEL_STDDEV,sp.MODEL_FAILURE_PROBABILITY));
+        builder.build_uct_tree(sp.INIT_S);
+        tree.clone_from(builder.p.root_node);
+        builder.p.root_node.clear_node();
+        nb_calls = builder.get_nb_calls();
+    }
+
+    opening_cache(const opening_cache &) = delete;
+    opening_cache & operator=(const opening_cache &) = delete;
+
+    /** @brief Test if the opening cache is used by the policy of the configuration */
+    static bool is_enabled(const parameters &sp) {
+        return sp.OPENING_BUDGET > 0 && sp.POLICY_SELECTOR <= 2;
+    }
+};
+
+#endif // OPENING_HPP_
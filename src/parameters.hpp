@@ -16,7 +16,7 @@ struct parameters {
     double FAILURE_PROBABILITY; ///< Probability with chich the oposite action effect is applied (randomness of the transition function)
     double INIT_S; ///< Initial state
     std::vector<int> ACTION_SPACE; ///< Action space used by every nodes (bandit arms)
-    unsigned POLICY_SELECTOR; ///< Policy selector (0: vanilla UCT; 1: plain OLUCT; default: epsilon-optimal policy)
+    unsigned POLICY_SELECTOR; ///< Policy selector (0: vanilla UCT; 1: plain OLUCT; 3: expectimax; default: epsilon-optimal policy)
     unsigned BUDGET; ///< Algorithm budget (number of expanded nodes)
     unsigned HORIZON; ///< Algorithm horizon for the default policy
     double UCT_CST; ///< UCT constant factor
@@ -29,6 +29,37 @@ struct parameters {
     double STATE_VARIANCE_THRESHOLD;
     double DISTANCE_THRESHOLD;
     double OUTCOME_VARIANCE_THRESHOLD;
+    unsigned TREE_MEMORY_CAP = 0; ///< Memory cap of the tree in kB (0: no cap)
+    unsigned HISTORY_KEEP = 8; ///< Number of samples kept per node when the histories are compacted
+    bool PERF_COUNTERS = false; ///< If true, hardware counters are collected (Linux only)
+    std::string OUTPUT_FORMAT = "csv"; ///< Format of the backup files ("csv" or "bin")
+    bool AGGREGATE = false; ///< If true, a single summary row is saved per configuration
+    double CI_TARGET_WIDTH = 0.; ///< Target width of the confidence interval on the mean score (0: fixed number of episodes)
+    double CI_COST_TARGET_WIDTH = 0.; ///< Target width of the confidence interval on the mean computational cost (0: no target)
+    double CONFIDENCE = .95; ///< Confidence level of the intervals
+    unsigned MAX_EPISODES = 100000; ///< Maximum number of episodes of the sequential stopping mode
+    unsigned BATCH_SIZE = 64; ///< Number of episodes run in parallel between two stopping tests
+    unsigned long long SEED = 0; ///< Base seed of the episodes (0: not reproducible)
+    std::string JOURNAL_PATH = ""; ///< Journal of the sweeps, used to resume them (empty: no journal)
+    unsigned NB_WORKERS = 0; ///< Number of worker processes of the sweeps (0: single process)
+    std::string SOCKET_PATH = "/tmp/1dtrack_planner.sock"; ///< Unix socket of the planner service
+    unsigned SERVER_MAX_BATCH = 16; ///< Maximum number of requests per batch of the planner service
+    bool SPECULATIVE_PLANNING = false; ///< If true, OLUCT grows its tree in the background while the environment steps
+    unsigned SPECULATION_BUDGET = 0; ///< Maximum number of background expansions per step (0: the budget)
+    double STEP_DURATION_MS = 0.; ///< Simulated duration of an environment step in milliseconds
+    bool WARM_START = false; ///< If true, an OLUCT rebuild is seeded with the values of the rejected tree
+    double WARM_START_CONFIDENCE = .5; ///< Fraction of the visits of the rejected tree kept as virtual visits
+    unsigned OPENING_BUDGET = 0; ///< Budget of the opening tree shared by the episodes of a configuration (0: no opening)
+    bool DECISION_CACHE = false; ///< If true, the decisions of vanilla UCT are memoized by quantized state
+    double DECISION_CACHE_QUANTUM = 1e-3; ///< Quantization step of the states of the decision cache
+    unsigned DECISION_CACHE_SIZE = 100000; ///< Maximum number of decisions of the decision cache
+    unsigned DECISION_CACHE_MIN_VISITS = 0; ///< Minimum number of visits of the recommended action to memoize a decision
+    bool DISCRETE_FAST_PATH = false; ///< If true, the noise-free configurations run on the discrete track and model
+    unsigned EXPECTIMAX_DEPTH = 10; ///< Depth of the expectimax search with enumerated outcomes
+    unsigned SPARSE_SAMPLING_DEPTH = 2; ///< Depth of the expectimax search with sampled outcomes
+    unsigned SPARSE_SAMPLING_WIDTH = 4; ///< Number of sampled outcomes per action of the sparse sampling
+    unsigned EXPECTIMAX_THREADS = 1; ///< Number of threads of the expectimax search (1: sequential, 0: hardware threads)
+    bool SYMMETRY_FOLDING = false; ///< If true, the mirrored states s and -s are folded by UCT, OLUCT and expectimax
 
     /**
      * @brief Simulation parameters 'default' constructor
@@ -110,6 +141,7 @@ struct parameters {
                 }
             }
             parse_decision_criterion(DECISION_CRITERIA);
+            parse_optional_parameters(cfg);
         }
         else { // Error in config file
             throw wrong_syntax_configuration_file_exception();
@@ -128,6 +160,58 @@ struct parameters {
         std::cerr << e.getError() << std::endl;
     }
 
+    /**
+     * @brief Parse optional parameters
+     *
+     * Parse the parameters that may be omitted in the configuration file, the default
+     * values set in the class definition are kept otherwise.
+     * @param {const libconfig::Config &} cfg; parsed configuration file
+     */
+    void parse_optional_parameters(const libconfig::Config &cfg) {
+        cfg.lookupValue("tree_memory_cap",TREE_MEMORY_CAP);
+        cfg.lookupValue("history_keep",HISTORY_KEEP);
+        cfg.lookupValue("perf_counters",PERF_COUNTERS);
+        cfg.lookupValue("output_format",OUTPUT_FORMAT);
+        cfg.lookupValue("aggregate",AGGREGATE);
+        cfg.lookupValue("ci_target_width",CI_TARGET_WIDTH);
+        cfg.lookupValue("ci_cost_target_width",CI_COST_TARGET_WIDTH);
+        cfg.lookupValue("confidence",CONFIDENCE);
+        cfg.lookupValue("max_episodes",MAX_EPISODES);
+        cfg.lookupValue("batch_size",BATCH_SIZE);
+        cfg.lookupValue("seed",SEED);
+        cfg.lookupValue("journal_path",JOURNAL_PATH);
+        cfg.lookupValue("nb_workers",NB_WORKERS);
+        cfg.lookupValue("socket_path",SOCKET_PATH);
+        cfg.lookupValue("server_max_batch",SERVER_MAX_BATCH);
+        cfg.lookupValue("speculative_planning",SPECULATIVE_PLANNING);
+        cfg.lookupValue("speculation_budget",SPECULATION_BUDGET);
+        cfg.lookupValue("step_duration_ms",STEP_DURATION_MS);
+        cfg.lookupValue("warm_start",WARM_START);
+        cfg.lookupValue("warm_start_confidence",WARM_START_CONFIDENCE);
+        cfg.lookupValue("opening_budget",OPENING_BUDGET);
+        cfg.lookupValue("decision_cache",DECISION_CACHE);
+        cfg.lookupValue("decision_cache_quantum",DECISION_CACHE_QUANTUM);
+        cfg.lookupValue("decision_cache_size",DECISION_CACHE_SIZE);
+        cfg.lookupValue("decision_cache_min_visits",DECISION_CACHE_MIN_VISITS);
+        cfg.lookupValue("discrete_fast_path",DISCRETE_FAST_PATH);
+        cfg.lookupValue("expectimax_depth",EXPECTIMAX_DEPTH);
+        cfg.lookupValue("sparse_sampling_depth",SPARSE_SAMPLING_DEPTH);
+        cfg.lookupValue("sparse_sampling_width",SPARSE_SAMPLING_WIDTH);
+        cfg.lookupValue("expectimax_threads",EXPECTIMAX_THREADS);
+        cfg.lookupValue("symmetry_folding",SYMMETRY_FOLDING);
+    }
+
+    /**
+     * @brief Is discrete
+     *
+     * Test if the episodes of the configuration run on the discrete track and model: the fast
+     * path is enabled, the environment and the model are noise-free and the initial state is
+     * an integer, so that every state is an integer.
+     */
+    bool is_discrete() const {
+        return DISCRETE_FAST_PATH && STDDEV == 0. && MODEL_STDDEV == 0. && INIT_S == std::floor(INIT_S);
+    }
+
     /**
      * @brief Parse decision criterion
      *
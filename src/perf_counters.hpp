@@ -0,0 +1,261 @@
+#ifndef PERF_COUNTERS_HPP_
+#define PERF_COUNTERS_HPP_
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Hardware counters
+ *
+ * Counters of a perf counter group, the first one being the group leader.
+ */
+enum perf_counter {
+    PERF_INSTRUCTIONS,
+    PERF_CYCLES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    NB_PERF_COUNTERS
+};
+
+constexpr unsigned PERF_ROLLOUT_SAMPLING_PERIOD = 16; ///< One rollout in 16 is measured
+
+/**
+ * @brief Counter group reading
+ *
+ * Raw counts of a group along with the times during which it was enabled and running; the
+ * two times differ if the kernel multiplexed the counters.
+ */
+struct perf_reading {
+    unsigned long long values[NB_PERF_COUNTERS]; ///< Raw counts
+    unsigned long long time_enabled; ///< Time enabled in nanoseconds
+    unsigned long long time_running; ///< Time running in nanoseconds
+};
+
+/**
+ * @brief Get the counters names
+ *
+ * @return Return a vector containing the name of each counter in the order of 'perf_counter'.
+ */
+std::vector<std::string> get_perf_counters_names() {
+    return std::vector<std::string>{"instructions", "cycles", "llc_misses", "branch_misses"};
+}
+
+/**
+ * @brief Perf counter group
+ *
+ * Group of hardware counters opened with 'perf_event_open' for the calling thread (user
+ * space only). If the counters cannot be opened (permissions, virtualized machine, non
+ * Linux system), the group is flagged as unavailable and reading it fails gracefully. The
+ * enabled and running times are read along with the counts, so that the counts can be scaled
+ * if the counters are multiplexed.
+ */
+struct perf_counter_group {
+    int fds[NB_PERF_COUNTERS]; ///< File descriptors, the first one is the group leader
+    bool available; ///< True if every counter has been opened
+    std::string error; ///< Error message if unavailable
+
+    /** @brief Constructor, open and enable the counters */
+    perf_counter_group() : available(false) {
+        for(auto &fd : fds) {
+            fd = -1;
+        }
+#ifdef __linux__
+        const unsigned long long configs[NB_PERF_COUNTERS] = {
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for(unsigned i=0; i<NB_PERF_COUNTERS; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr,0,sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = (i == 0) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = (int) syscall(__NR_perf_event_open,&attr,0,-1,(i == 0) ? -1 : fds[0],0);
+            if(fds[i] < 0) {
+                error = std::string("perf_event_open: ") + std::strerror(errno);
+                close_all();
+                return;
+            }
+        }
+        ioctl(fds[0],PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0],PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+        available = true;
+#else
+        error = "perf_event_open: not a Linux system";
+#endif
+    }
+
+    /** @brief Destructor, close the counters */
+    ~perf_counter_group() {
+        close_all();
+    }
+
+    perf_counter_group(const perf_counter_group &) = delete;
+    perf_counter_group & operator=(const perf_counter_group &) = delete;
+
+    /** @brief Close every opened counter */
+    void close_all() {
+#ifdef __linux__
+        for(auto &fd : fds) {
+            if(fd >= 0) {
+                close(fd);
+            }
+            fd = -1;
+        }
+#endif
+        available = false;
+    }
+
+    /**
+     * @brief Read the counters
+     *
+     * @param {perf_reading &} reading; filled with the current counts and times
+     * @return Return true if the counters have been read.
+     */
+    bool read_counters(perf_reading &reading) {
+#ifdef __linux__
+        if(available) {
+            unsigned long long buffer[3 + NB_PERF_COUNTERS]; // {nr, enabled, running, values...}
+            if(read(fds[0],buffer,sizeof(buffer)) == (ssize_t) sizeof(buffer)) {
+                reading.time_enabled = buffer[1];
+                reading.time_running = buffer[2];
+                for(unsigned i=0; i<NB_PERF_COUNTERS; ++i) {
+                    reading.values[i] = buffer[3 + i];
+                }
+                return true;
+            }
+        }
+#else
+        (void) reading;
+#endif
+        return false;
+    }
+};
+
+/**
+ * @brief Local perf counter group
+ *
+ * The counter group of the calling thread, opened at the first call. A warning is printed
+ * once per thread if the counters are unavailable.
+ * @return Return a reference to the counter group of the thread.
+ */
+perf_counter_group & local_perf_counters() {
+    static thread_local perf_counter_group group;
+    static thread_local bool warned = false;
+    if(!group.available && !warned) {
+        std::cerr << "Warning: hardware counters unavailable (" << group.error << ")\n";
+        warned = true;
+    }
+    return group;
+}
+
+/**
+ * @brief Perf counts
+ *
+ * Accumulated counts of a scope, scaled by the enabled to running time ratio of each
+ * measurement. If the scope is sampled (see 'perf_scope'), the backed up counts are
+ * extrapolated to every entry of the scope.
+ */
+struct perf_counts {
+    double values[NB_PERF_COUNTERS]; ///< Accumulated counts of the measured entries
+    unsigned long long nb_entries; ///< Number of entries of the scope
+    unsigned long long nb_measured; ///< Number of measured entries
+    bool valid; ///< False if a measurement of the scope failed
+
+    /** @brief Constructor */
+    perf_counts() {
+        reset();
+    }
+
+    /** @brief Reset the counts */
+    void reset() {
+        for(auto &v : values) {
+            v = 0.;
+        }
+        nb_entries = 0;
+        nb_measured = 0;
+        valid = true;
+    }
+
+    /**
+     * @brief Get the backed up values
+     *
+     * @return Return the counts extrapolated to every entry, NaN if a measurement failed.
+     */
+    std::vector<double> get_backup() const {
+        double scale = (nb_measured > 0) ? (double) nb_entries / (double) nb_measured : 0.;
+        std::vector<double> v;
+        for(auto &val : values) {
+            v.push_back(valid ? val * scale : std::numeric_limits<double>::quiet_NaN());
+        }
+        return v;
+    }
+};
+
+/**
+ * @brief Perf scope
+ *
+ * Add the counts of the thread counter group between its construction and its destruction
+ * to the given accumulated counts. Does nothing if the accumulated counts pointer is null.
+ * With a sampling period N, only one entry of the scope in N is measured, since reading the
+ * group costs a system call: short and frequent scopes (the rollouts) are sampled.
+ */
+struct perf_scope {
+    perf_counts * counts; ///< Accumulated counts, nullptr if disabled or not sampled
+    perf_reading start; ///< Counts at construction
+
+    /**
+     * @brief Constructor
+     *
+     * @param {perf_counts *} _counts; accumulated counts, nullptr if disabled
+     * @param {unsigned} sampling_period; one entry in 'sampling_period' is measured
+     */
+    explicit perf_scope(perf_counts * _counts, unsigned sampling_period = 1) : counts(_counts) {
+        if(counts == nullptr) {
+            return;
+        }
+        if(counts->nb_entries++ % sampling_period != 0) {
+            counts = nullptr;
+        } else if(!local_perf_counters().read_counters(start)) {
+            counts->valid = false;
+            counts = nullptr;
+        }
+    }
+
+    /** @brief Destructor, the counts are scaled if the counters were multiplexed */
+    ~perf_scope() {
+        if(counts != nullptr) {
+            perf_reading end;
+            if(local_perf_counters().read_counters(end)) {
+                unsigned long long enabled = end.time_enabled - start.time_enabled;
+                unsigned long long running = end.time_running - start.time_running;
+                double scale = (running > 0) ? (double) enabled / (double) running : 1.;
+                for(unsigned i=0; i<NB_PERF_COUNTERS; ++i) {
+                    counts->values[i] += scale * (double) (end.values[i] - start.values[i]);
+                }
+                ++counts->nb_measured;
+            } else {
+                counts->valid = false;
+            }
+        }
+    }
+};
+
+#endif // PERF_COUNTERS_HPP_
@@ -0,0 +1,226 @@
+#ifndef PLANNER_HPP_
+#define PLANNER_HPP_
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <vector>
+
+#include <parameters.hpp>
+#include <agent.hpp>
+#include <thread_pool.hpp>
+
+/**
+ * @brief Planner
+ *
+ * Embeddable interface of the agent, meant to be driven by an external control loop:
+ * 'decide' returns the action at the observed state, 'observe' gives the next state reached
+ * by the controlled system and 'reset' starts a new episode. The memory of the decisions is
+ * reserved at construction (node pool, sample arena and scratch buffers) and a few warm-up
+ * decisions are run, so that the steady-state decisions do not call the heap allocator.
+ * The node pool and the sample arena belong to the calling thread (see 'local_node_pool'),
+ * hence a planner should be created and used by the same thread.
+ * The memory cap of the tree ('tree_memory_cap') allocates when it prunes the tree.
+ */
+struct planner {
+    agent ag; ///< Planning agent, its tree is kept between the decisions
+
+    /**
+     * @brief Constructor
+     *
+     * @param {parameters &} sp; parameters of the policy and of its model
+     * @param {unsigned} nb_warmup_decisions; number of decisions run to fill the free lists
+     */
+    explicit planner(parameters &sp, unsigned nb_warmup_decisions = 16) :
+        ag(sp.INIT_S,policy_parameters(sp),model(sp.MODEL_TRACK_LEN,sp.MODEL_STDDEV,sp.MODEL_FAILURE_PROBABILITY))
+    {
+        node_pool &pool = local_node_pool();
+        pool.reserve(pool.free_nodes.size() + ag.p.budget + 1,ag.p.action_space);
+        local_sample_arena().reserve(4);
+        ag.p.root_node.children.reserve(ag.p.action_space.size());
+        ag.modes_values.reserve(ag.p.budget + 1);
+        ag.modes_counters.reserve(ag.p.budget + 1);
+        warm_up(nb_warmup_decisions);
+        reset(sp.INIT_S);
+    }
+
+    /** @brief Destructor, recycle the tree */
+    ~planner() {
+        ag.stop_speculation();
+        ag.p.root_node.clear_node();
+    }
+
+    planner(const planner &) = delete;
+    planner & operator=(const planner &) = delete;
+
+    /**
+     * @brief Warm up
+     *
+     * Run decisions along an episode simulated with the model, restarting at the initial
+     * state when a terminal state is reached.
+     * @param {unsigned} nb_decisions; number of decisions
+     */
+    void warm_up(unsigned nb_decisions) {
+        double init_s = ag.s;
+        for(unsigned i=0; i<nb_decisions; ++i) {
+            if(ag.m.is_terminal(ag.s)) {
+                reset(init_s);
+            }
+            decide();
+            observe(ag.m.transition_model(ag.s,ag.a));
+        }
+    }
+
+    /**
+     * @brief Decide
+     *
+     * @param {double} state; observed state of the controlled system
+     * @return Return the recommended action.
+     */
+    int decide(double state) {
+        observe(state);
+        return decide();
+    }
+
+    /**
+     * @brief Decide at the last observed state
+     *
+     * @return Return the recommended action.
+     */
+    int decide() {
+        ag.stop_speculation();
+        ag.take_action();
+        ag.start_speculation();
+        return ag.a;
+    }
+
+    /**
+     * @brief Observe
+     *
+     * Set the state reached after the last decision; with OLUCT, the sub-tree of the taken
+     * action is reused at the next decision if the decision criteria accept it. With the
+     * speculative planning, this sub-tree is grown in the background between 'decide' and
+     * 'observe'.
+     * @param {double} next_state; observed state
+     */
+    void observe(double next_state) {
+        ag.stop_speculation();
+        ag.s = next_state;
+    }
+
+    /**
+     * @brief Reset
+     *
+     * Discard the tree and start a new episode at the given state.
+     * @param {double} state; initial state of the episode
+     */
+    void reset(double state) {
+        ag.stop_speculation();
+        ag.p.root_node.clear_node();
+        ag.p.root_node.set_state(state);
+        ag.s = state;
+        ag.a = 0;
+    }
+
+    /** @brief Get the number of calls to the model since the creation */
+    unsigned get_nb_calls() {
+        return ag.get_nb_calls();
+    }
+};
+
+/**
+ * @brief Batch planner
+ *
+ * Plan the actions of many independent states in one call, for instance the agents of a
+ * fleet. The states are split into contiguous ranges, each range being planned by a single
+ * task of the global thread pool so that the task creation, the wake-up of the worker and the
+ * scratch agent of the task are shared by all the states of the range.
+ * A state may come with a tree handle: the agent holding the tree of this state, which is
+ * then kept between the calls (OLUCT sub-tree reuse); the handles of a call must be
+ * distinct. The other states are planned from scratch with the scratch agent of their task.
+ * As with 'agent::take_action', the states should not be terminal. Should not be called from
+ * a task of the global thread pool.
+ */
+struct batch_planner {
+    policy_parameters p; ///< Policy parameters of the scratch agents
+    model m; ///< Model of the scratch agents
+    unsigned states_per_task; ///< Number of states per task (0: automatic)
+    std::atomic<unsigned long long> nb_calls; ///< Number of calls to the model of the batches
+
+    /**
+     * @brief Constructor
+     *
+     * @param {parameters &} sp; parameters of the policy and of its model
+     * @param {unsigned} _states_per_task; number of states per task, if 0 the states are
+     * split into four ranges per worker to balance the load
+     */
+    explicit batch_planner(parameters &sp, unsigned _states_per_task = 0) :
+        p(sp),
+        m(sp.MODEL_TRACK_LEN,sp.MODEL_STDDEV,sp.MODEL_FAILURE_PROBABILITY),
+        states_per_task(_states_per_task),
+        nb_calls(0)
+    {}
+
+    /**
+     * @brief Decide
+     *
+     * Plan the action of every state and wait for the whole batch.
+     * @param {const double *} states; states, 'nb_states' of them
+     * @param {int *} actions; recommended actions, 'nb_states' of them
+     * @param {size_t} nb_states; number of states
+     * @param {agent * const *} trees; tree handle of each state, nullptr for the states
+     * planned from scratch (or nullptr if no state has a tree)
+     */
+    void decide(const double * states, int * actions, size_t nb_states, agent * const * trees = nullptr) {
+        thread_pool &pool = global_thread_pool();
+        size_t range_size = states_per_task;
+        if(range_size == 0) {
+            size_t nb_ranges = 4 * (size_t) pool.get_nb_threads();
+            range_size = std::max((nb_states + nb_ranges - 1) / nb_ranges,(size_t) 1);
+        }
+        std::vector<std::future<void>> done;
+        done.reserve((nb_states + range_size - 1) / range_size);
+        for(size_t begin=0; begin<nb_states; begin+=range_size) {
+            size_t end = std::min(begin + range_size,nb_states);
+            done.push_back(pool.submit([=]() {plan_range(states,actions,trees,begin,end);}));
+        }
+        std::exception_ptr error;
+        for(auto &d : done) { // every task is waited for before rethrowing
+            try {
+                d.get();
+            }
+            catch(...) {
+                error = std::current_exception();
+            }
+        }
+        if(error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief Plan a range
+     *
+     * Plan the states of indices in ['begin', 'end'). Called by a worker.
+     */
+    void plan_range(const double * states, int * actions, agent * const * trees, size_t begin, size_t end) {
+        agent scratch(0.,p,m);
+        unsigned long long range_calls = 0;
+        for(size_t i=begin; i<end; ++i) {
+            bool has_tree = (trees != nullptr && trees[i] != nullptr);
+            agent &ag = has_tree ? *trees[i] : scratch;
+            if(!has_tree) {
+                ag.p.root_node.clear_node();
+            }
+            unsigned calls_before = ag.get_nb_calls();
+            ag.s = states[i];
+            ag.take_action();
+            actions[i] = ag.a;
+            range_calls += ag.get_nb_calls() - calls_before;
+        }
+        scratch.p.root_node.clear_node();
+        nb_calls += range_calls;
+    }
+};
+
+#endif // PLANNER_HPP_
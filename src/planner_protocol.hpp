@@ -0,0 +1,149 @@
+#ifndef PLANNER_PROTOCOL_HPP_
+#define PLANNER_PROTOCOL_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Planner protocol
+ *
+ * Binary protocol of the planner service (see 'server/'), over a Unix domain socket. Every
+ * message is a fixed-size frame, every field being little-endian:
+ * - request (24 bytes): uint32 magic; uint16 type; uint16 reserved; uint64 request id;
+ * float64 state;
+ * - response (56 bytes): uint32 magic; uint16 type; uint16 status; uint64 request id;
+ * int64 action; 4 x float64 values.
+ * A client sends its requests in order and gets one response per request, in the same order.
+ * The 'values' of a 'PLANNER_DECIDE' response are: the service latency in microseconds, the
+ * number of nodes of the tree of the client, 1 if the tree has been reused (0 otherwise) and 0.
+ * The 'values' of a 'PLANNER_STATS' response are: the number of served requests, the number of
+ * batches, the median and the 99th percentile of the service latency in microseconds.
+ */
+constexpr uint32_t PLANNER_MAGIC = 0x50544431; ///< "1DTP" once written in little-endian
+constexpr unsigned PLANNER_REQUEST_SIZE = 24; ///< Size of a request frame in bytes
+constexpr unsigned PLANNER_RESPONSE_SIZE = 56; ///< Size of a response frame in bytes
+
+/**
+ * @brief Planner request types
+ */
+enum planner_request_type {
+    PLANNER_DECIDE = 1, ///< Get the action at the given state, the tree of the client is kept
+    PLANNER_RESET = 2, ///< Reset the tree of the client, the action is not computed
+    PLANNER_STATS = 3 ///< Get the counters of the service
+};
+
+/**
+ * @brief Planner response status
+ */
+enum planner_status {
+    PLANNER_OK = 0,
+    PLANNER_BAD_REQUEST = 1
+};
+
+/**
+ * @brief Planner request
+ */
+struct planner_request {
+    uint16_t type; ///< Request type (see 'planner_request_type')
+    uint64_t id; ///< Request id, copied in the response
+    double state; ///< State of the agent of the client
+};
+
+/**
+ * @brief Planner response
+ */
+struct planner_response {
+    uint16_t type; ///< Type of the answered request
+    uint16_t status; ///< Status (see 'planner_status')
+    uint64_t id; ///< Id of the answered request
+    int64_t action; ///< Recommended action
+    double values[4]; ///< Values depending on the request type
+};
+
+/** @brief Write an unsigned integer in little-endian */
+template <class T>
+inline void put_little_endian(unsigned char * out, T value) {
+    for(unsigned i=0; i<sizeof(T); ++i) {
+        out[i] = (unsigned char) ((value >> (8 * i)) & 0xff);
+    }
+}
+
+/** @brief Read an unsigned integer in little-endian */
+template <class T>
+inline T get_little_endian(const unsigned char * in) {
+    T value = 0;
+    for(unsigned i=0; i<sizeof(T); ++i) {
+        value |= ((T) in[i]) << (8 * i);
+    }
+    return value;
+}
+
+/** @brief Write a double in little-endian */
+inline void put_double(unsigned char * out, double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits,&value,sizeof(bits));
+    put_little_endian<uint64_t>(out,bits);
+}
+
+/** @brief Read a double in little-endian */
+inline double get_double(const unsigned char * in) {
+    uint64_t bits = get_little_endian<uint64_t>(in);
+    double value = 0.;
+    std::memcpy(&value,&bits,sizeof(value));
+    return value;
+}
+
+/** @brief Encode a request into a frame of 'PLANNER_REQUEST_SIZE' bytes */
+inline void encode_request(const planner_request &req, unsigned char * out) {
+    put_little_endian<uint32_t>(out,PLANNER_MAGIC);
+    put_little_endian<uint16_t>(out + 4,req.type);
+    put_little_endian<uint16_t>(out + 6,0);
+    put_little_endian<uint64_t>(out + 8,req.id);
+    put_double(out + 16,req.state);
+}
+
+/**
+ * @brief Decode a request
+ *
+ * @param {const unsigned char *} in; frame of 'PLANNER_REQUEST_SIZE' bytes
+ * @param {planner_request &} req; decoded request
+ * @return Return false if the magic number is wrong.
+ */
+inline bool decode_request(const unsigned char * in, planner_request &req) {
+    req.type = get_little_endian<uint16_t>(in + 4);
+    req.id = get_little_endian<uint64_t>(in + 8);
+    req.state = get_double(in + 16);
+    return get_little_endian<uint32_t>(in) == PLANNER_MAGIC;
+}
+
+/** @brief Encode a response into a frame of 'PLANNER_RESPONSE_SIZE' bytes */
+inline void encode_response(const planner_response &res, unsigned char * out) {
+    put_little_endian<uint32_t>(out,PLANNER_MAGIC);
+    put_little_endian<uint16_t>(out + 4,res.type);
+    put_little_endian<uint16_t>(out + 6,res.status);
+    put_little_endian<uint64_t>(out + 8,res.id);
+    put_little_endian<uint64_t>(out + 16,(uint64_t) res.action);
+    for(unsigned i=0; i<4; ++i) {
+        put_double(out + 24 + 8 * i,res.values[i]);
+    }
+}
+
+/**
+ * @brief Decode a response
+ *
+ * @param {const unsigned char *} in; frame of 'PLANNER_RESPONSE_SIZE' bytes
+ * @param {planner_response &} res; decoded response
+ * @return Return false if the magic number is wrong.
+ */
+inline bool decode_response(const unsigned char * in, planner_response &res) {
+    res.type = get_little_endian<uint16_t>(in + 4);
+    res.status = get_little_endian<uint16_t>(in + 6);
+    res.id = get_little_endian<uint64_t>(in + 8);
+    res.action = (int64_t) get_little_endian<uint64_t>(in + 16);
+    for(unsigned i=0; i<4; ++i) {
+        res.values[i] = get_double(in + 24 + 8 * i);
+    }
+    return get_little_endian<uint32_t>(in) == PLANNER_MAGIC;
+}
+
+#endif // PLANNER_PROTOCOL_HPP_
@@ -0,0 +1,192 @@
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Phases of the UCT loop
+ *
+ * Phases timed by the profiler. The tree policy phase includes the expansion phase, see
+ * 'phase_profiler::get_time_ms'.
+ */
+enum uct_phase {
+    PHASE_TREE_POLICY,
+    PHASE_EXPAND,
+    PHASE_DEFAULT_POLICY,
+    PHASE_BACKUP,
+    PHASE_STATE_MULTIMODALITY,
+    PHASE_STATE_VARIANCE,
+    PHASE_STATE_DISTANCE,
+    PHASE_OUTCOME_VARIANCE,
+    NB_PHASES
+};
+
+/**
+ * @brief Get the phases names
+ *
+ * @return Return a vector containing the name of each phase in the order of 'uct_phase'.
+ */
+std::vector<std::string> get_phases_names() {
+    return std::vector<std::string>{
+        "tree_policy",
+        "expand",
+        "default_policy",
+        "backup",
+        "state_multimodality_test",
+        "state_variance_test",
+        "state_distance_test",
+        "outcome_variance_test"
+    };
+}
+
+/**
+ * @brief Read ticks
+ *
+ * Cheap timestamp reader: the time stamp counter on x86, the steady clock in nanoseconds
+ * otherwise.
+ * @return Return the current number of ticks.
+ */
+inline unsigned long long read_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief Ticks per millisecond
+ *
+ * Calibrate the ticks against the steady clock, once, at the first call.
+ * @return Return the number of ticks per millisecond.
+ */
+double ticks_per_ms() {
+    static const double calibration = []() {
+        auto t0 = std::chrono::steady_clock::now();
+        unsigned long long k0 = read_ticks();
+        while(std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(10)) {}
+        unsigned long long k1 = read_ticks();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return ((double) (k1 - k0)) / ms;
+    }();
+    return calibration;
+}
+
+/**
+ * @brief Phase profiler
+ *
+ * Accumulate the number of ticks spent in each phase and the number of times each phase
+ * was entered.
+ */
+struct phase_profiler {
+    unsigned long long ticks[NB_PHASES]; ///< Accumulated ticks per phase
+    unsigned long long counts[NB_PHASES]; ///< Number of entries per phase
+
+    /** @brief Constructor */
+    phase_profiler() {
+        reset();
+    }
+
+    /** @brief Reset the accumulated ticks and counts */
+    void reset() {
+        for(unsigned i=0; i<NB_PHASES; ++i) {
+            ticks[i] = 0;
+            counts[i] = 0;
+        }
+    }
+
+    /** @brief Record one entry of the phase lasting the given number of ticks */
+    void add(uct_phase ph, unsigned long long nb_ticks) {
+        ticks[ph] += nb_ticks;
+        counts[ph] += 1;
+    }
+
+    /**
+     * @brief Get the time spent in a phase
+     *
+     * The time spent in the expansion phase is removed from the tree policy phase so that
+     * the latter only accounts for the descent.
+     * @param {uct_phase} ph; phase
+     * @return Return the time spent in the phase in milliseconds.
+     */
+    double get_time_ms(uct_phase ph) const {
+        unsigned long long t = ticks[ph];
+        if(ph == PHASE_TREE_POLICY) {
+            t -= std::min(t,ticks[PHASE_EXPAND]);
+        }
+        return ((double) t) / ticks_per_ms();
+    }
+
+    /**
+     * @brief Get the backed up values
+     *
+     * @return Return the time (ms) and the count of each phase, in the order of the names
+     * given by 'get_profiler_values_names'.
+     */
+    std::vector<double> get_backup() const {
+        std::vector<double> v;
+        for(unsigned i=0; i<NB_PHASES; ++i) {
+            v.push_back(get_time_ms((uct_phase) i));
+            v.push_back((double) counts[i]);
+        }
+        return v;
+    }
+};
+
+/**
+ * @brief Get the profiler values names
+ *
+ * @return Return the names of the values given by 'phase_profiler::get_backup'.
+ */
+std::vector<std::string> get_profiler_values_names() {
+    std::vector<std::string> v;
+    for(auto &name : get_phases_names()) {
+        v.push_back(name + "_ms");
+        v.push_back(name + "_count");
+    }
+    return v;
+}
+
+/**
+ * @brief Phase scope
+ *
+ * Record the time between its construction and its destruction into the profiler.
+ */
+struct phase_scope {
+    phase_profiler &prof; ///< Profiler
+    uct_phase ph; ///< Timed phase
+    unsigned long long start; ///< Ticks at construction
+
+    /** @brief Constructor */
+    phase_scope(phase_profiler &_prof, uct_phase _ph) : prof(_prof), ph(_ph) {
+        start = read_ticks();
+    }
+
+    /** @brief Destructor */
+    ~phase_scope() {
+        prof.add(ph,read_ticks() - start);
+    }
+};
+
+/**
+ * @brief Profile phase macro
+ *
+ * Time the enclosing scope as the given phase. Compiled out unless 'UCT_PROFILE' is defined
+ * (see the 'PROFILE' variable of the Makefile).
+ */
+#define PROFILE_CONCAT_IMPL(x, y) x##y
+#define PROFILE_CONCAT(x, y) PROFILE_CONCAT_IMPL(x, y)
+#ifdef UCT_PROFILE
+#define PROFILE_PHASE(prof, ph) phase_scope PROFILE_CONCAT(phase_scope_, __LINE__)(prof, ph)
+#else
+#define PROFILE_PHASE(prof, ph)
+#endif
+
+#endif // PROFILER_HPP_
@@ -0,0 +1,238 @@
+#ifndef RESULT_SINK_HPP_
+#define RESULT_SINK_HPP_
+
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Format an unsigned integer
+ *
+ * Write the decimal digits of the integer at the given position, 'to_chars' style.
+ * @param {char *} out; output position, at least 20 characters available
+ * @param {unsigned long long} n; formatted integer
+ * @return Return the position following the last written character.
+ */
+inline char * format_integer(char * out, unsigned long long n) {
+    char digits[20];
+    unsigned nb = 0;
+    do {
+        digits[nb++] = (char) ('0' + n % 10);
+        n /= 10;
+    } while(n != 0);
+    while(nb > 0) {
+        *out++ = digits[--nb];
+    }
+    return out;
+}
+
+/**
+ * @brief Format a number
+ *
+ * Write a number at the given position, 'to_chars' style. Integral values (most of the
+ * saved values: scores, numbers of calls, counts) take a fast path without any call to the
+ * C library, other values are written with 10 significant digits.
+ * @param {char *} out; output position, at least 32 characters available
+ * @param {double} v; formatted number
+ * @return Return the position following the last written character.
+ */
+inline char * format_number(char * out, double v) {
+    if(v == v && std::fabs(v) < 9e15 && v == (double) (long long) v) {
+        if(v < 0.) {
+            *out++ = '-';
+            v = -v;
+        }
+        return format_integer(out,(unsigned long long) v);
+    }
+    return out + std::snprintf(out,32,"%.10g",v);
+}
+
+/** @brief Format a string */
+inline void append_formatted(std::string &line, const std::string &v) {
+    line += v;
+}
+
+/** @brief Format a number, see 'format_number' */
+template <class T>
+inline void append_formatted(std::string &line, const T &v) {
+    char buffer[32];
+    line.append(buffer,format_number(buffer,(double) v));
+}
+
+/**
+ * @brief Result sink
+ *
+ * Buffered writer of result files. The file is opened once; the rows are formatted by the
+ * calling threads into a large user-space buffer which is handed over to a background
+ * thread writing it to the disk when full. Hence the calling threads never wait for the
+ * disk. Rows can be written by several threads concurrently. A failed write is reported by
+ * the next 'flush' or by 'close'.
+ */
+struct result_sink {
+    std::FILE * file; ///< Output file
+    size_t buffer_size; ///< Size above which the current buffer is handed over
+    std::string current; ///< Buffer being filled
+    std::deque<std::string> pending; ///< Full buffers waiting to be written
+    std::vector<std::string> spare; ///< Written buffers kept for reuse
+    std::mutex mtx; ///< Protects the buffers
+    std::condition_variable cv_writer; ///< Wakes up the writer thread
+    std::condition_variable cv_flushed; ///< Signals that the pending buffers are written
+    bool writing; ///< True while the writer thread writes a buffer
+    bool stop; ///< Stops the writer thread
+    bool failed; ///< True once a write failed
+    bool closed; ///< True once the file is closed
+    std::thread writer; ///< Background writer thread
+
+    /**
+     * @brief Constructor
+     *
+     * Open the output file and start the writer thread.
+     * @param {const std::string &} output_path; the output path
+     * @param {bool} append; if true, the rows are appended to the existing file, otherwise
+     * the file is overridden
+     * @param {size_t} _buffer_size; size of the user-space buffers in bytes
+     */
+    result_sink(
+        const std::string &output_path,
+        bool append = false,
+        size_t _buffer_size = 1 << 20) :
+        buffer_size(_buffer_size),
+        writing(false),
+        stop(false),
+        failed(false),
+        closed(false)
+    {
+        file = std::fopen(output_path.c_str(),append ? "ab" : "wb");
+        if(file == nullptr) {
+            throw std::runtime_error("cannot open result file " + output_path);
+        }
+        current.reserve(buffer_size + 4096);
+        writer = std::thread(&result_sink::write_loop,this);
+    }
+
+    /** @brief Destructor, write every buffered row and close the file, use 'close' to get the errors */
+    ~result_sink() {
+        if(!closed) {
+            try {
+                close();
+            } catch(const std::exception &) {}
+        }
+    }
+
+    /**
+     * @brief Close
+     *
+     * Write every buffered row, stop the writer thread and close the file. Throw if a write
+     * failed.
+     */
+    void close() {
+        closed = true;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if(!current.empty()) {
+                hand_over();
+            }
+            stop = true;
+        }
+        cv_writer.notify_one();
+        writer.join();
+        bool close_failed = (std::fclose(file) != 0);
+        if(failed || close_failed) {
+            throw std::runtime_error("cannot write the result file");
+        }
+    }
+
+    result_sink(const result_sink &) = delete;
+    result_sink & operator=(const result_sink &) = delete;
+
+    /** @brief Writer thread loop */
+    void write_loop() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while(true) {
+            cv_writer.wait(lock,[this]() {return stop || !pending.empty();});
+            if(pending.empty()) { // stop requested and nothing left
+                return;
+            }
+            std::string buffer = std::move(pending.front());
+            pending.pop_front();
+            writing = true;
+            lock.unlock();
+            bool ok = (std::fwrite(buffer.data(),1,buffer.size(),file) == buffer.size());
+            buffer.clear();
+            lock.lock();
+            writing = false;
+            failed |= !ok;
+            spare.push_back(std::move(buffer));
+            if(pending.empty()) {
+                failed |= (std::fflush(file) != 0);
+                cv_flushed.notify_all();
+            }
+        }
+    }
+
+    /**
+     * @brief Hand over the current buffer
+     *
+     * The lock should be held by the caller.
+     */
+    void hand_over() {
+        pending.push_back(std::move(current));
+        if(spare.empty()) {
+            current = std::string();
+            current.reserve(buffer_size + 4096);
+        } else {
+            current = std::move(spare.back());
+            spare.pop_back();
+        }
+        cv_writer.notify_one();
+    }
+
+    /**
+     * @brief Write a row
+     *
+     * Format the row then append it to the current buffer. Template method.
+     * @param {const std::vector<T> &} v; the saved row
+     * @param {const std::string &} separator; the used separator
+     */
+    template <class T>
+    void write_row(const std::vector<T> &v, const std::string &separator) {
+        std::string line;
+        for(unsigned i=0; i<v.size(); ++i) {
+            append_formatted(line,v[i]);
+            if(i<v.size()-1) {
+                line += separator;
+            }
+        }
+        line += '\n';
+        std::lock_guard<std::mutex> lock(mtx);
+        current += line;
+        if(current.size() >= buffer_size) {
+            hand_over();
+        }
+    }
+
+    /**
+     * @brief Flush
+     *
+     * Hand over the current buffer and wait until every row written so far is on the disk.
+     * Throw if a write failed.
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mtx);
+        if(!current.empty()) {
+            hand_over();
+        }
+        cv_flushed.wait(lock,[this]() {return pending.empty() && !writing;});
+        if(failed) {
+            throw std::runtime_error("cannot write the result file");
+        }
+    }
+};
+
+#endif // RESULT_SINK_HPP_
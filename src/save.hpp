@@ -5,6 +5,11 @@
 
 #include <utils.hpp>
 #include <parameters.hpp>
+#include <profiler.hpp>
+#include <perf_counters.hpp>
+#include <result_sink.hpp>
+#include <columnar.hpp>
+#include <aggregate.hpp>
 
 /**
  * @brief Save a vector
@@ -40,8 +45,8 @@ void save_vector(
 /**
  * @brief Save a matrix
  *
- * Save a matrix into a file, writing subsequently each one of its line using the method
- * 'save_vector'. Template method.
+ * Save a matrix into a file, writing subsequently each one of its line. The file is opened
+ * once and written through a 'result_sink'. Template method.
  * @param {const std::vector<std::vector<T>> &} m; the saved matrix
  * @param {const std::string &} output_path; the output path (name of the file)
  * @param {const std::string &} separator; the used separator
@@ -56,9 +61,11 @@ void save_matrix(
     const std::string &separator,
 	std::ofstream::openmode mode = std::ofstream::out)
 {
+    result_sink sink(output_path,(mode & std::ofstream::app) != 0);
     for(auto &line : m) {
-        save_vector(line,output_path,separator,mode);
+        sink.write_row(line,separator);
     }
+    sink.close();
 }
 
 /**
@@ -84,16 +91,165 @@ void initialize_backup(
  * Get a vector containing the names of the saved values during each simulation.
  * @warning The values should be saved in the same ordering as in the 'simulate_episode'
  * method (edit 22/09/2017).
+ * @param {const parameters &} sp; parameters of the simulations, some values are saved
+ * only if enabled
  * @return Return a vector containing each name in order of appearance
  */
-std::vector<std::string> get_saved_values_names() {
+std::vector<std::string> get_saved_values_names(const parameters &sp) {
     std::vector<std::string> v;
     v.emplace_back("score");
     v.emplace_back("computational_cost");
     v.emplace_back("nb_calls");
+    v.emplace_back("wall_time_ms");
+    v.emplace_back("decision_p50_us");
+    v.emplace_back("decision_p99_us");
+    v.emplace_back("decision_max_us");
+    v.emplace_back("peak_nb_nodes");
+    v.emplace_back("peak_tree_bytes");
+    v.emplace_back("nb_pool_misses");
+    v.emplace_back("nb_recycled_nodes");
+    v.emplace_back("nb_decisions");
+    if(sp.DECISION_CACHE) {
+        v.emplace_back("decision_cache_hits");
+        v.emplace_back("decision_cache_misses");
+    }
+#ifdef UCT_PROFILE
+    for(auto &name : get_profiler_values_names()) {
+        v.push_back(name);
+    }
+#endif
+    if(sp.PERF_COUNTERS) {
+        for(auto &name : get_perf_counters_names()) {
+            v.push_back("build_" + name);
+        }
+        for(auto &name : get_perf_counters_names()) {
+            v.push_back("rollout_" + name);
+        }
+    }
     return v;
 }
 
+/**
+ * @brief Backup writer
+ *
+ * Writer of the backup file of a run, either as CSV through a 'result_sink' or in the
+ * binary columnar format through a 'columnar_writer'.
+ */
+struct backup_writer {
+    std::unique_ptr<result_sink> csv; ///< CSV writer, if the format is "csv"
+    std::unique_ptr<columnar_writer> bin; ///< Columnar writer, if the format is "bin"
+    std::string separator; ///< CSV separator
+
+    /**
+     * @brief Constructor
+     *
+     * Open the backup file and write the header.
+     * @param {const std::string &} output_path; the output path, its extension is replaced
+     * by '.bin' for the binary format
+     * @param {const std::vector<std::string> &} names; the names of the saved values
+     * @param {const std::string &} format; "csv" or "bin"
+     * @param {const std::string &} _separator; the CSV separator
+     */
+    backup_writer(
+        const std::string &output_path,
+        const std::vector<std::string> &names,
+        const std::string &format,
+        const std::string &_separator = ",") :
+        separator(_separator)
+    {
+        if(format == "csv") {
+            csv.reset(new result_sink(output_path));
+            csv->write_row(names,separator);
+        } else if(format == "bin") {
+            std::string path = output_path.substr(0,output_path.find_last_of('.')) + ".bin";
+            bin.reset(new columnar_writer(path,names));
+        } else {
+            throw output_format_exception();
+        }
+    }
+
+    /** @brief Write a row of saved values */
+    void write(const std::vector<double> &row) {
+        if(csv) {
+            csv->write_row(row,separator);
+        } else {
+            bin->write_row(row);
+        }
+    }
+
+    /** @brief Close the backup file, throw if it could not be written */
+    void close() {
+        if(csv) {
+            csv->close();
+        } else {
+            bin->close();
+        }
+    }
+};
+
+/**
+ * @brief Get the aggregate state path
+ *
+ * @param {const std::string &} summary_path; path of a summary file
+ * @return Return the path of the mergeable state saved next to the summary, e.g.
+ * 'data/test_state.bin' for 'data/test.csv'.
+ */
+std::string get_aggregate_state_path(const std::string &summary_path) {
+    return summary_path.substr(0,summary_path.find_last_of('.')) + "_state.bin";
+}
+
+/**
+ * @brief Save an aggregate state
+ *
+ * Save the mergeable state of an aggregate in the binary columnar format: one column per
+ * saved value, whose rows are the number of episodes then the state of its statistics (see
+ * 'running_stats::get_state').
+ * @param {const episode_aggregate &} aggregate; saved aggregate
+ * @param {const std::vector<std::string> &} names; the names of the saved values
+ * @param {const std::string &} output_path; the output path
+ */
+void save_aggregate_state(
+    const episode_aggregate &aggregate,
+    const std::vector<std::string> &names,
+    const std::string &output_path)
+{
+    assert(names.size() == aggregate.columns.size());
+    std::vector<std::vector<double>> states(names.size());
+    for(unsigned j=0; j<names.size(); ++j) {
+        states[j].push_back((double) aggregate.nb_episodes);
+        aggregate.columns[j].get_state(states[j]);
+    }
+    columnar_writer writer(output_path,names);
+    std::vector<double> row(names.size());
+    for(unsigned i=0; i<1 + running_stats::NB_STATE_VALUES; ++i) {
+        for(unsigned j=0; j<names.size(); ++j) {
+            row[j] = states[j][i];
+        }
+        writer.write_row(row);
+    }
+    writer.close();
+}
+
+/**
+ * @brief Load an aggregate state
+ *
+ * @param {const std::string &} input_path; path of a state saved by 'save_aggregate_state'
+ * @param {std::vector<std::string> &} names; filled with the names of the saved values
+ * @return Return the aggregate.
+ */
+episode_aggregate load_aggregate_state(const std::string &input_path, std::vector<std::string> &names) {
+    std::vector<std::vector<double>> states = read_columnar(input_path,names);
+    episode_aggregate aggregate((unsigned) names.size());
+    for(unsigned j=0; j<names.size(); ++j) {
+        if(states[j].size() != 1 + running_stats::NB_STATE_VALUES) {
+            throw std::runtime_error(input_path + " is not an aggregate state");
+        }
+        aggregate.nb_episodes = (unsigned long long) states[j][0];
+        aggregate.columns[j].set_state(states[j].data() + 1);
+    }
+    return aggregate;
+}
+
 void append_double(std::string &path, double d, std::string sep) {
     assert(!is_less_than(d,0.));
     if(is_equal_to(d,0.)) {
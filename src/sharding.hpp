@@ -0,0 +1,216 @@
+#ifndef SHARDING_HPP_
+#define SHARDING_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief Parse a CPU list
+ *
+ * Parse a CPU list in the sysfs format, e.g. "0-3,8-11".
+ * @param {const std::string &} list; the CPU list
+ * @return Return the indices of the listed CPUs.
+ */
+std::vector<int> parse_cpulist(const std::string &list) {
+    std::vector<int> cpus;
+    const char * str = list.c_str();
+    char * str_end = nullptr;
+    while(*str != '\0' && *str != '\n') {
+        int first = (int) std::strtol(str,&str_end,10);
+        if(str_end == str) {
+            break;
+        }
+        int last = first;
+        if(*str_end == '-') {
+            str = str_end + 1;
+            last = (int) std::strtol(str,&str_end,10);
+        }
+        for(int c=first; c<=last; ++c) {
+            cpus.push_back(c);
+        }
+        str = (*str_end == ',') ? str_end + 1 : str_end;
+    }
+    return cpus;
+}
+
+/**
+ * @brief Get the NUMA nodes CPUs
+ *
+ * Read the CPUs of each NUMA node in '/sys/devices/system/node'. If this information is not
+ * available, a single node containing every CPU is returned.
+ * @return Return the CPUs of each NUMA node.
+ */
+std::vector<std::vector<int>> get_numa_nodes_cpus() {
+    std::vector<std::vector<int>> nodes;
+    for(unsigned k=0; ; ++k) {
+        std::ifstream infile("/sys/devices/system/node/node" + std::to_string(k) + "/cpulist");
+        std::string list;
+        if(!infile || !std::getline(infile,list)) {
+            break;
+        }
+        std::vector<int> cpus = parse_cpulist(list);
+        if(!cpus.empty()) { // memory-only nodes are skipped
+            nodes.push_back(cpus);
+        }
+    }
+    if(nodes.empty()) {
+        nodes.push_back(std::vector<int>());
+        for(unsigned c=0; c<std::max(std::thread::hardware_concurrency(),1u); ++c) {
+            nodes.back().push_back((int) c);
+        }
+    }
+    return nodes;
+}
+
+/**
+ * @brief Pin to CPUs
+ *
+ * Restrict the calling process to the given CPUs. Its memory is then allocated on their
+ * NUMA node by the first-touch policy.
+ * @param {const std::vector<int> &} cpus; the CPUs
+ * @return Return true on success.
+ */
+bool pin_to_cpus(const std::vector<int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(auto c : cpus) {
+        if(c >= 0 && c < CPU_SETSIZE) {
+            CPU_SET(c,&set);
+        }
+    }
+    return sched_setaffinity(0,sizeof(set),&set) == 0;
+}
+
+/**
+ * @brief Process nonce
+ *
+ * Seed material unique to the calling process: a hardware random number mixed with the
+ * process id and a high resolution clock, so that processes started in the same second, or
+ * forked from the same parent, get distinct seeds.
+ * @return Return the nonce.
+ */
+unsigned long long process_nonce() {
+    unsigned long long nonce = mix_seed((unsigned long long) std::random_device{}(),(unsigned long long) getpid());
+    return mix_seed(nonce,(unsigned long long) std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+/**
+ * @brief Shared results
+ *
+ * Results array shared by a parent process and its forked workers (anonymous shared
+ * mapping): each job owns a fixed slot of 'stride' values and a completion flag. The parent
+ * reads the slots once the workers have exited.
+ */
+struct shared_results {
+    size_t nb_jobs; ///< Number of jobs
+    size_t stride; ///< Number of values per job
+    size_t mapping_size; ///< Size of the mapping in bytes
+    void * mapping; ///< Shared mapping
+    double * values; ///< Values, 'stride' per job
+    unsigned char * done; ///< Completion flag of each job
+
+    /**
+     * @brief Constructor
+     *
+     * Map the shared array, before forking the workers.
+     * @param {size_t} _nb_jobs; number of jobs
+     * @param {size_t} _stride; maximum number of values per job
+     */
+    shared_results(size_t _nb_jobs, size_t _stride) : nb_jobs(_nb_jobs), stride(_stride) {
+        mapping_size = nb_jobs * stride * sizeof(double) + nb_jobs + 1;
+        mapping = mmap(nullptr,mapping_size,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_ANONYMOUS,-1,0);
+        if(mapping == MAP_FAILED) {
+            throw std::runtime_error("cannot map the shared results");
+        }
+        values = static_cast<double *>(mapping);
+        done = reinterpret_cast<unsigned char *>(values + nb_jobs * stride);
+    }
+
+    /** @brief Destructor */
+    ~shared_results() {
+        munmap(mapping,mapping_size);
+    }
+
+    shared_results(const shared_results &) = delete;
+    shared_results & operator=(const shared_results &) = delete;
+
+    /** @brief Store the values of a job then flag it as done */
+    void store(size_t job, const std::vector<double> &row) {
+        assert(job < nb_jobs && row.size() <= stride);
+        std::copy(row.begin(),row.end(),values + job * stride);
+        __atomic_store_n(done + job,(unsigned char) 1,__ATOMIC_RELEASE);
+    }
+
+    /** @brief Test if a job is done */
+    bool is_done(size_t job) const {
+        return __atomic_load_n(done + job,__ATOMIC_ACQUIRE) != 0;
+    }
+
+    /** @brief Load the 'nb_values' first values of a job */
+    std::vector<double> load(size_t job, size_t nb_values) const {
+        assert(job < nb_jobs && nb_values <= stride);
+        return std::vector<double>(values + job * stride,values + job * stride + nb_values);
+    }
+};
+
+/**
+ * @brief Fork workers
+ *
+ * Fork the worker processes, pin worker 'w' to the CPUs of NUMA node 'w' modulo the number of
+ * nodes, run 'work(w)' in each of them and wait for all of them. Each worker reseeds its
+ * random engine from its process nonce and its indice, so that the workers do not replay the
+ * random stream inherited from the parent. Should be called while the calling process runs no
+ * other thread. Template method.
+ * @param {unsigned} nb_workers; number of worker processes
+ * @param {F} work; callable taking the worker indice
+ * @return Return the number of workers which failed.
+ */
+template <class F>
+unsigned fork_workers(unsigned nb_workers, F work) {
+    std::vector<std::vector<int>> nodes = get_numa_nodes_cpus();
+    std::vector<pid_t> pids;
+    for(unsigned w=0; w<nb_workers; ++w) {
+        pid_t pid = fork();
+        if(pid < 0) {
+            throw std::runtime_error("cannot fork the sweep workers");
+        }
+        if(pid == 0) { // worker
+            int status = 0;
+            try {
+                pin_to_cpus(nodes[w % nodes.size()]);
+                set_random_seed(mix_seed(process_nonce(),w));
+                work(w);
+            }
+            catch(const std::exception &e) {
+                std::cerr << "Error in worker " << w << ": " << e.what() << std::endl;
+                status = 1;
+            }
+            _exit(status); // no destructor of the parent state runs in the worker
+        }
+        pids.push_back(pid);
+    }
+    unsigned nb_failures = 0;
+    for(auto pid : pids) {
+        int status = 0;
+        if(waitpid(pid,&status,0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ++nb_failures;
+        }
+    }
+    return nb_failures;
+}
+
+#endif // SHARDING_HPP_
@@ -0,0 +1,434 @@
+#ifndef SMALL_VECTOR_HPP_
+#define SMALL_VECTOR_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+struct sample_arena;
+
+/**
+ * @brief Sample chunk header
+ *
+ * Header at the start of every chunk of a sample arena. The chunks are aligned on
+ * 'sample_arena::CHUNK_SIZE', hence the arena owning a block is found from its address.
+ */
+struct sample_chunk_header {
+    sample_arena * owner; ///< Arena which carved the chunk
+};
+
+/**
+ * @brief Sample arena
+ *
+ * Allocator for the spilled storage of the small vectors. Blocks have power-of-two sizes
+ * and are carved from large chunks; a released block is pushed on a free list of its size
+ * class in the arena owning its chunk, and reused by the next allocation of the same class.
+ * Each thread owns an arena (see 'local_sample_arena'). A block released by its owner thread
+ * goes on a local free list, a block released by another thread (e.g. a node grown by a
+ * worker and recycled by the agent) goes on a remote free list of its owner, protected by a
+ * mutex and collected by the owner when its local free list of the class is empty. Hence
+ * the memory of a thread is reused by this thread only and does not migrate to the free
+ * lists of the other threads.
+ * The chunks are not given back to the system, since blocks of an arena may outlive its
+ * thread: at the exit of a thread, its arena becomes an orphan, adopted with its chunks and
+ * free lists by the next thread needing an arena. The number of arenas is thus bounded by
+ * the peak number of threads using them.
+ */
+struct sample_arena {
+    static const unsigned NB_SIZE_CLASSES = 32; ///< Number of size classes (log2 of the size)
+    static const size_t CHUNK_SIZE = 1 << 20; ///< Size and alignment of a chunk in bytes
+    static const size_t HEADER_SIZE = 64; ///< Bytes taken by the header at the start of a chunk
+    static const unsigned MIN_SIZE_CLASS = 4; ///< Smallest block is 16 bytes
+    void * free_lists[NB_SIZE_CLASSES]; ///< Heads of the intrusive free lists
+    char * cursor; ///< Next free byte of the current chunk
+    size_t remaining; ///< Remaining bytes in the current chunk
+    unsigned nb_chunks; ///< Number of chunks taken from the system
+    void * spare_chunks; ///< Reserved chunks not used yet, intrusive list
+    std::mutex remote_mtx; ///< Protects the remote free lists
+    void * remote_lists[NB_SIZE_CLASSES]; ///< Heads of the blocks released by the other threads
+    std::atomic<bool> has_remote; ///< True if a remote free list may not be empty
+    sample_arena * next_orphan; ///< Next arena of the orphans list
+
+    /** @brief Constructor */
+    sample_arena() :
+        cursor(nullptr),
+        remaining(0),
+        nb_chunks(0),
+        spare_chunks(nullptr),
+        has_remote(false),
+        next_orphan(nullptr)
+    {
+        for(unsigned c=0; c<NB_SIZE_CLASSES; ++c) {
+            free_lists[c] = nullptr;
+            remote_lists[c] = nullptr;
+        }
+    }
+
+    /**
+     * @brief Size class
+     *
+     * @param {size_t} bytes; requested size
+     * @return Return the log2 of the smallest block size able to hold the requested size.
+     */
+    static unsigned size_class(size_t bytes) {
+        unsigned c = MIN_SIZE_CLASS;
+        while((((size_t) 1) << c) < bytes) {
+            ++c;
+        }
+        return c;
+    }
+
+    /** @brief Get the arena of the calling thread, nullptr if none (or after its exit) */
+    static sample_arena *& local_pointer() {
+        static thread_local sample_arena * arena = nullptr;
+        return arena;
+    }
+
+    /** @brief Get the arena owning a block */
+    static sample_arena * owner_of(void * block) {
+        std::uintptr_t chunk = reinterpret_cast<std::uintptr_t>(block) & ~((std::uintptr_t) CHUNK_SIZE - 1);
+        return reinterpret_cast<sample_chunk_header *>(chunk)->owner;
+    }
+
+    /**
+     * @brief New chunk
+     *
+     * Take a chunk aligned on 'CHUNK_SIZE' from the system and write its header.
+     * @param {size_t} bytes; size of the chunk, header included
+     * @return Return the chunk.
+     */
+    char * new_chunk(size_t bytes) {
+        ++nb_chunks;
+        char * base = static_cast<char *>(::operator new(bytes + CHUNK_SIZE));
+        std::uintptr_t misalignment = reinterpret_cast<std::uintptr_t>(base) % CHUNK_SIZE;
+        char * chunk = base + ((misalignment == 0) ? 0 : CHUNK_SIZE - misalignment);
+        reinterpret_cast<sample_chunk_header *>(chunk)->owner = this;
+        return chunk;
+    }
+
+    /**
+     * @brief Collect the remote blocks
+     *
+     * Move the blocks released by the other threads to the local free lists.
+     */
+    void collect_remote() {
+        std::lock_guard<std::mutex> lock(remote_mtx);
+        for(unsigned c=0; c<NB_SIZE_CLASSES; ++c) {
+            while(remote_lists[c] != nullptr) {
+                void * block = remote_lists[c];
+                remote_lists[c] = *static_cast<void **>(block);
+                *static_cast<void **>(block) = free_lists[c];
+                free_lists[c] = block;
+            }
+        }
+        has_remote.store(false,std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Allocate
+     *
+     * @param {unsigned} c; size class of the block
+     * @return Return a block of 2^c bytes.
+     */
+    void * allocate(unsigned c) {
+        if(free_lists[c] == nullptr && has_remote.load(std::memory_order_relaxed)) {
+            collect_remote();
+        }
+        if(free_lists[c] != nullptr) {
+            void * block = free_lists[c];
+            free_lists[c] = *static_cast<void **>(block);
+            return block;
+        }
+        size_t bytes = ((size_t) 1) << c;
+        if(bytes > CHUNK_SIZE / 4) { // large blocks are not carved from the chunks
+            return new_chunk(HEADER_SIZE + bytes) + HEADER_SIZE;
+        }
+        if(remaining < bytes) {
+            char * chunk = nullptr;
+            if(spare_chunks != nullptr) {
+                chunk = static_cast<char *>(spare_chunks);
+                spare_chunks = *reinterpret_cast<void **>(chunk + HEADER_SIZE);
+            } else {
+                chunk = new_chunk(CHUNK_SIZE);
+            }
+            cursor = chunk + HEADER_SIZE;
+            remaining = CHUNK_SIZE - HEADER_SIZE;
+        }
+        void * block = cursor;
+        cursor += bytes;
+        remaining -= bytes;
+        return block;
+    }
+
+    /**
+     * @brief Reserve
+     *
+     * Take chunks from the system in advance, so that the next allocations of up to
+     * 'nb_reserved_chunks' chunks do not call the system allocator.
+     * @param {unsigned} nb_reserved_chunks; number of chunks to reserve
+     */
+    void reserve(unsigned nb_reserved_chunks) {
+        for(unsigned i=0; i<nb_reserved_chunks; ++i) {
+            char * chunk = new_chunk(CHUNK_SIZE);
+            *reinterpret_cast<void **>(chunk + HEADER_SIZE) = spare_chunks;
+            spare_chunks = chunk;
+        }
+    }
+
+    /**
+     * @brief Deallocate
+     *
+     * Push the block on a free list of its size class in its owner arena: the local free
+     * list if the calling thread owns the arena, the remote one otherwise.
+     * @param {void *} block; released block
+     * @param {unsigned} c; size class of the block
+     */
+    static void deallocate(void * block, unsigned c) {
+        sample_arena * owner = owner_of(block);
+        if(owner == local_pointer()) {
+            *static_cast<void **>(block) = owner->free_lists[c];
+            owner->free_lists[c] = block;
+            return;
+        }
+        std::lock_guard<std::mutex> lock(owner->remote_mtx);
+        *static_cast<void **>(block) = owner->remote_lists[c];
+        owner->remote_lists[c] = block;
+        owner->has_remote.store(true,std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Sample arena orphans
+ *
+ * Arenas of the exited threads, adopted by the new threads. The arenas are never destroyed.
+ */
+struct sample_arena_orphans {
+    std::mutex mtx; ///< Protects the list
+    sample_arena * head; ///< First orphan, nullptr if none
+
+    /** @brief Adopt an orphan, or create an arena if there is none */
+    sample_arena * adopt() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if(head != nullptr) {
+                sample_arena * arena = head;
+                head = arena->next_orphan;
+                arena->next_orphan = nullptr;
+                return arena;
+            }
+        }
+        return new sample_arena();
+    }
+
+    /** @brief Give the arena of an exiting thread to the orphans */
+    void release(sample_arena * arena) {
+        std::lock_guard<std::mutex> lock(mtx);
+        arena->next_orphan = head;
+        head = arena;
+    }
+};
+
+/** @brief Get the orphans of the sample arenas */
+inline sample_arena_orphans & global_sample_arena_orphans() {
+    static sample_arena_orphans orphans; // trivially destructible, usable by the exiting threads
+    return orphans;
+}
+
+/**
+ * @brief Sample arena guard
+ *
+ * Thread-local guard giving the arena of the thread to the orphans at the exit of the
+ * thread. The blocks released afterwards by the thread, e.g. by the destructors of the other
+ * thread-local objects, go to the remote free lists.
+ */
+struct sample_arena_guard {
+    /** @brief Destructor */
+    ~sample_arena_guard() {
+        sample_arena *& arena = sample_arena::local_pointer();
+        if(arena != nullptr) {
+            global_sample_arena_orphans().release(arena);
+            arena = nullptr;
+        }
+    }
+};
+
+/**
+ * @brief Local sample arena
+ *
+ * Should not be called once the thread-local objects of the thread are being destroyed.
+ * @return Return the sample arena of the calling thread, adopted at the first call.
+ */
+inline sample_arena & local_sample_arena() {
+    sample_arena *& arena = sample_arena::local_pointer();
+    if(arena == nullptr) {
+        static thread_local sample_arena_guard guard;
+        arena = global_sample_arena_orphans().adopt();
+    }
+    return *arena;
+}
+
+/**
+ * @brief Small vector
+ *
+ * Vector storing up to N elements inline, spilling to the sample arena of the thread when
+ * it grows larger. Only meant for trivially copyable types. Template class.
+ */
+template <class T, unsigned N>
+struct small_vector {
+private :
+    T * data_; ///< Pointer to the elements, either 'inline_data' or a spilled block
+    unsigned size_; ///< Number of elements
+    unsigned capacity_; ///< Number of elements that fit in the current storage
+    T inline_data[N]; ///< Inline storage
+
+    /** @brief Is the storage spilled to the arena */
+    bool is_spilled() const {return data_ != inline_data;}
+
+    /** @brief Release the spilled storage, if any */
+    void release() {
+        if(is_spilled()) {
+            sample_arena::deallocate(data_,sample_arena::size_class(capacity_ * sizeof(T)));
+            data_ = inline_data;
+            capacity_ = N;
+        }
+    }
+
+    /**
+     * @brief Reallocate
+     *
+     * Move the elements to a storage able to hold 'n' elements, the inline storage is used
+     * if it is large enough.
+     */
+    void reallocate(unsigned n) {
+        T * new_data = inline_data;
+        unsigned new_capacity = N;
+        if(n <= N) {
+            if(!is_spilled()) {
+                return;
+            }
+        } else {
+            unsigned c = sample_arena::size_class(n * sizeof(T));
+            if(is_spilled() && c == sample_arena::size_class(capacity_ * sizeof(T))) {
+                return;
+            }
+            new_data = static_cast<T *>(local_sample_arena().allocate(c));
+            new_capacity = (unsigned) ((((size_t) 1) << c) / sizeof(T));
+        }
+        std::memmove(new_data,data_,size_ * sizeof(T));
+        T * old_data = data_;
+        unsigned old_capacity = capacity_;
+        data_ = new_data;
+        capacity_ = new_capacity;
+        if(old_data != inline_data) {
+            sample_arena::deallocate(old_data,sample_arena::size_class(old_capacity * sizeof(T)));
+        }
+    }
+
+public :
+    typedef T value_type;
+    typedef T * iterator;
+    typedef const T * const_iterator;
+
+    /** @brief Constructor */
+    small_vector() : data_(inline_data), size_(0), capacity_(N) {}
+
+    /** @brief Copy constructor */
+    small_vector(const small_vector &other) : data_(inline_data), size_(0), capacity_(N) {
+        *this = other;
+    }
+
+    /** @brief Move constructor, steals the spilled storage */
+    small_vector(small_vector &&other) noexcept : data_(inline_data), size_(0), capacity_(N) {
+        *this = std::move(other);
+    }
+
+    /** @brief Destructor */
+    ~small_vector() {release();}
+
+    /** @brief Copy assignment */
+    small_vector & operator=(const small_vector &other) {
+        if(this != &other) {
+            size_ = 0;
+            if(other.size_ > capacity_) {
+                reallocate(other.size_);
+            }
+            std::memcpy(data_,other.data_,other.size_ * sizeof(T));
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    /** @brief Move assignment */
+    small_vector & operator=(small_vector &&other) noexcept {
+        if(this != &other) {
+            if(other.is_spilled()) {
+                release();
+                data_ = other.data_;
+                capacity_ = other.capacity_;
+                size_ = other.size_;
+                other.data_ = other.inline_data;
+                other.capacity_ = N;
+            } else {
+                std::memcpy(data_,other.data_,other.size_ * sizeof(T));
+                size_ = other.size_;
+            }
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    /** @brief Get the number of elements */
+    unsigned size() const {return size_;}
+
+    /** @brief Get the number of elements that fit in the current storage */
+    unsigned capacity() const {return capacity_;}
+
+    /** @brief Is empty */
+    bool empty() const {return size_ == 0;}
+
+    /** @brief Get the number of bytes spilled to the arena */
+    size_t spilled_bytes() const {return is_spilled() ? capacity_ * sizeof(T) : 0;}
+
+    /** @brief Append an element, the capacity is doubled when full */
+    void push_back(const T &value) {
+        if(size_ == capacity_) {
+            reallocate(2 * capacity_);
+        }
+        data_[size_++] = value;
+    }
+
+    /** @brief Clear the elements, the storage is kept */
+    void clear() {size_ = 0;}
+
+    /** @brief Erase the elements in [first, last) */
+    void erase(iterator first, iterator last) {
+        std::memmove(first,last,(end() - last) * sizeof(T));
+        size_ -= (unsigned) (last - first);
+    }
+
+    /** @brief Reduce the storage to the smallest one able to hold the elements */
+    void shrink_to_fit() {
+        reallocate(size_);
+    }
+
+    T & operator[](unsigned i) {return data_[i];}
+    const T & operator[](unsigned i) const {return data_[i];}
+    T & back() {assert(size_ > 0); return data_[size_ - 1];}
+    const T & back() const {assert(size_ > 0); return data_[size_ - 1];}
+    iterator begin() {return data_;}
+    iterator end() {return data_ + size_;}
+    const_iterator begin() const {return data_;}
+    const_iterator end() const {return data_ + size_;}
+
+    /** @brief Get a copy of the elements as a standard vector */
+    std::vector<T> to_vector() const {
+        return std::vector<T>(begin(),end());
+    }
+};
+
+#endif // SMALL_VECTOR_HPP_
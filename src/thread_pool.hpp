@@ -0,0 +1,140 @@
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Thread pool
+ *
+ * Fixed set of worker threads executing the submitted tasks in submission order. The
+ * workers persist between the tasks, hence the thread-local resources (node pool, sample
+ * arena, random engine, counters) are reused from one task to the next.
+ */
+struct thread_pool {
+    std::vector<std::thread> workers; ///< Worker threads
+    std::deque<std::function<void()>> tasks; ///< Tasks waiting for a worker
+    std::mutex mtx; ///< Protects the tasks queue
+    std::condition_variable cv; ///< Wakes up the workers
+    bool stop; ///< Stops the workers
+
+    /**
+     * @brief Constructor
+     *
+     * Start the workers.
+     * @param {unsigned} nb_threads; number of workers, the number of hardware threads if 0
+     */
+    explicit thread_pool(unsigned nb_threads = 0) : stop(false) {
+        if(nb_threads == 0) {
+            nb_threads = std::max(std::thread::hardware_concurrency(),1u);
+        }
+        for(unsigned i=0; i<nb_threads; ++i) {
+            workers.emplace_back(&thread_pool::work_loop,this);
+        }
+    }
+
+    /** @brief Destructor, execute the remaining tasks then join the workers */
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        for(auto &w : workers) {
+            w.join();
+        }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool & operator=(const thread_pool &) = delete;
+
+    /** @brief Worker loop */
+    void work_loop() {
+        while(true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock,[this]() {return stop || !tasks.empty();});
+                if(tasks.empty()) { // stop requested and nothing left
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    /**
+     * @brief Submit a task
+     *
+     * Template method.
+     * @param {F} f; callable without argument
+     * @return Return a future holding the result of the task, or the exception it threw.
+     */
+    template <class F>
+    std::future<typename std::result_of<F()>::type> submit(F f) {
+        typedef typename std::result_of<F()>::type R;
+        std::shared_ptr<std::packaged_task<R()>> task(new std::packaged_task<R()>(std::move(f)));
+        std::future<R> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            tasks.emplace_back([task]() {(*task)();});
+        }
+        cv.notify_one();
+        return result;
+    }
+
+    /** @brief Get the number of workers */
+    unsigned get_nb_threads() const {
+        return (unsigned) workers.size();
+    }
+};
+
+/**
+ * @brief Global thread pool
+ *
+ * Thread pool shared by the whole program, started at the first call with one worker per
+ * hardware thread.
+ * @return Return a reference to the global thread pool.
+ */
+thread_pool & global_thread_pool() {
+    static thread_pool pool;
+    return pool;
+}
+
+/**
+ * @brief Search thread pool
+ *
+ * Thread pool of the root-parallel searches (see 'expectimax_search'), distinct from the
+ * global thread pool so that an episode running on the latter can wait for its search tasks.
+ * Started at the first call with the given number of workers, later values being ignored.
+ * @param {unsigned} nb_threads; number of workers, the number of hardware threads if 0
+ * @return Return a reference to the search thread pool.
+ */
+thread_pool & search_thread_pool(unsigned nb_threads) {
+    static thread_pool pool(nb_threads);
+    return pool;
+}
+
+/**
+ * @brief Local speculation pool
+ *
+ * Single background worker of the calling thread, used to grow the tree of its agent while
+ * the environment steps (speculative planning). Started at the first call.
+ * @return Return a reference to the speculation pool of the calling thread.
+ */
+thread_pool & local_speculation_pool() {
+    static thread_local thread_pool pool(1);
+    return pool;
+}
+
+#endif // THREAD_POOL_HPP_
@@ -0,0 +1,154 @@
+#ifndef TIMING_HPP_
+#define TIMING_HPP_
+
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <time.h>
+
+/**
+ * @brief Wall clock
+ *
+ * Monotonic wall clock.
+ * @return Return the current time in milliseconds, from an arbitrary origin.
+ */
+double wall_clock_ms() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Thread CPU clock
+ *
+ * CPU time consumed by the calling thread only, hence not polluted by the other threads of
+ * the process. Fall back to the process CPU time if the thread clock is not available.
+ * @return Return the CPU time of the thread in milliseconds.
+ */
+double thread_cpu_time_ms() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts) == 0) {
+        return 1000. * ((double) ts.tv_sec) + 1e-6 * ((double) ts.tv_nsec);
+    }
+#endif
+    return 1000. * ((double) std::clock()) / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief Stopwatch
+ *
+ * Measure both the wall-clock time and the thread CPU time elapsed since its construction
+ * or its last restart.
+ */
+struct stopwatch {
+    double wall_start; ///< Wall-clock time at start (ms)
+    double cpu_start; ///< Thread CPU time at start (ms)
+
+    /** @brief Constructor, start the stopwatch */
+    stopwatch() {
+        restart();
+    }
+
+    /** @brief Restart the stopwatch */
+    void restart() {
+        wall_start = wall_clock_ms();
+        cpu_start = thread_cpu_time_ms();
+    }
+
+    /** @brief Get the elapsed wall-clock time in milliseconds */
+    double wall_ms() const {return wall_clock_ms() - wall_start;}
+
+    /** @brief Get the elapsed thread CPU time in milliseconds */
+    double cpu_ms() const {return thread_cpu_time_ms() - cpu_start;}
+};
+
+/**
+ * @brief Latency histogram
+ *
+ * Log-linear histogram of latencies in microseconds: each power of two is split into
+ * 'NB_SUB_BUCKETS' buckets, hence the quantiles are given with a relative error below
+ * 1/NB_SUB_BUCKETS in constant memory. The maximum is recorded exactly.
+ */
+struct latency_histogram {
+    static const unsigned NB_SUB_BUCKETS = 16; ///< Number of buckets per power of two
+    static const unsigned NB_EXPONENTS = 40; ///< Number of powers of two (up to ~12 days)
+    unsigned long long buckets[NB_EXPONENTS * NB_SUB_BUCKETS]; ///< Counts
+    unsigned long long count; ///< Number of recorded latencies
+    double max; ///< Maximum recorded latency
+
+    /** @brief Constructor */
+    latency_histogram() {
+        reset();
+    }
+
+    /** @brief Reset the histogram */
+    void reset() {
+        for(auto &b : buckets) {
+            b = 0;
+        }
+        count = 0;
+        max = 0.;
+    }
+
+    /** @brief Get the indice of the bucket of a latency */
+    static unsigned bucket_of(double us) {
+        if(us < 1.) {
+            return (unsigned) (std::max(us,0.) * NB_SUB_BUCKETS);
+        }
+        int e = 0;
+        double m = std::frexp(us,&e); // us = m * 2^e with m in [.5,1)
+        unsigned ind = ((unsigned) e) * NB_SUB_BUCKETS + (unsigned) ((2. * m - 1.) * NB_SUB_BUCKETS);
+        return std::min(ind,NB_EXPONENTS * NB_SUB_BUCKETS - 1);
+    }
+
+    /** @brief Get the upper bound of a bucket in microseconds */
+    static double bucket_upper_bound(unsigned ind) {
+        unsigned e = ind / NB_SUB_BUCKETS;
+        double sub = (double) (ind % NB_SUB_BUCKETS + 1);
+        if(e == 0) {
+            return sub / NB_SUB_BUCKETS;
+        }
+        return std::ldexp(1. + sub / NB_SUB_BUCKETS,(int) e - 1);
+    }
+
+    /** @brief Record a latency in microseconds */
+    void record(double us) {
+        ++buckets[bucket_of(us)];
+        ++count;
+        max = std::max(max,us);
+    }
+
+    /** @brief Merge another histogram into this one */
+    void merge(const latency_histogram &other) {
+        for(unsigned i=0; i<NB_EXPONENTS * NB_SUB_BUCKETS; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        max = std::max(max,other.max);
+    }
+
+    /**
+     * @brief Quantile
+     *
+     * @param {double} q; quantile level in [0,1]
+     * @return Return the upper bound of the bucket containing the quantile, capped by the
+     * maximum, 0 if the histogram is empty.
+     */
+    double quantile(double q) const {
+        if(count == 0) {
+            return 0.;
+        }
+        unsigned long long rank = (unsigned long long) std::ceil(q * (double) count);
+        rank = std::max(rank,1ULL);
+        unsigned long long cumul = 0;
+        for(unsigned i=0; i<NB_EXPONENTS * NB_SUB_BUCKETS; ++i) {
+            cumul += buckets[i];
+            if(cumul >= rank) {
+                return std::min(bucket_upper_bound(i),max);
+            }
+        }
+        return max;
+    }
+};
+
+#endif // TIMING_HPP_
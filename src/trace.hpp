@@ -0,0 +1,153 @@
+#ifndef TRACE_HPP_
+#define TRACE_HPP_
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <profiler.hpp>
+
+/**
+ * @brief Trace event
+ *
+ * Event in the Chrome trace format: 'B' (begin), 'E' (end) or 'i' (instant). The name
+ * should be a string literal.
+ */
+struct trace_event {
+    const char * name; ///< Name of the event
+    char phase; ///< Phase of the event ('B', 'E' or 'i')
+    unsigned long long ticks; ///< Timestamp (see 'read_ticks')
+};
+
+/**
+ * @brief Trace buffer
+ *
+ * Ring buffer of the events of a single thread. Only its thread writes into it, without
+ * lock; the oldest events are overwritten when the buffer is full. The buffers are read by
+ * 'write_chrome_trace' once the traced threads are done.
+ */
+struct trace_buffer {
+    static const unsigned CAPACITY = 1 << 16; ///< Number of events kept per thread
+    std::vector<trace_event> events; ///< Ring storage
+    std::atomic<unsigned long long> nb_events; ///< Number of events recorded since creation
+    unsigned tid; ///< Index of the thread in the trace
+
+    /** @brief Constructor */
+    explicit trace_buffer(unsigned _tid) : events(CAPACITY), nb_events(0), tid(_tid) {}
+
+    /** @brief Record an event */
+    void record(const char * name, char phase) {
+        unsigned long long n = nb_events.load(std::memory_order_relaxed);
+        trace_event &e = events[n % CAPACITY];
+        e.name = name;
+        e.phase = phase;
+        e.ticks = read_ticks();
+        nb_events.store(n + 1,std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Trace registry
+ *
+ * Registry of the buffers of every traced thread. The buffers outlive their threads so
+ * that they can be flushed at the end of the program.
+ */
+struct trace_registry {
+    std::mutex mtx; ///< Protects the registration of the buffers
+    std::vector<std::unique_ptr<trace_buffer>> buffers; ///< Buffers of every thread
+
+    /** @brief Register a new buffer for the calling thread */
+    trace_buffer * register_thread() {
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers.emplace_back(new trace_buffer((unsigned) buffers.size()));
+        return buffers.back().get();
+    }
+};
+
+/** @brief Get the global trace registry */
+trace_registry & global_trace_registry() {
+    static trace_registry registry;
+    return registry;
+}
+
+/** @brief Get the trace buffer of the calling thread, registered at the first call */
+trace_buffer & local_trace_buffer() {
+    static thread_local trace_buffer * buffer = global_trace_registry().register_thread();
+    return *buffer;
+}
+
+/**
+ * @brief Write Chrome trace
+ *
+ * Write every recorded event as a Chrome trace JSON file, readable by 'chrome://tracing'
+ * or Perfetto. Should be called once the traced threads are done.
+ * @param {const std::string &} output_path; the output path
+ */
+void write_chrome_trace(const std::string &output_path) {
+    trace_registry &registry = global_trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    unsigned long long origin = ~0ULL;
+    for(auto &buf : registry.buffers) {
+        unsigned long long n = buf->nb_events.load(std::memory_order_acquire);
+        unsigned long long first = (n > trace_buffer::CAPACITY) ? n - trace_buffer::CAPACITY : 0;
+        if(n > first) {
+            origin = std::min(origin,buf->events[first % trace_buffer::CAPACITY].ticks);
+        }
+    }
+    double us_per_tick = 1000. / ticks_per_ms();
+    std::ofstream outfile(output_path);
+    outfile << "{\"traceEvents\":[\n";
+    bool first_event = true;
+    for(auto &buf : registry.buffers) {
+        unsigned long long n = buf->nb_events.load(std::memory_order_acquire);
+        unsigned long long first = (n > trace_buffer::CAPACITY) ? n - trace_buffer::CAPACITY : 0;
+        for(unsigned long long i=first; i<n; ++i) {
+            const trace_event &e = buf->events[i % trace_buffer::CAPACITY];
+            outfile << (first_event ? "" : ",\n");
+            outfile << "{\"name\":\"" << e.name << "\",\"ph\":\"" << e.phase << "\",";
+            outfile << "\"ts\":" << ((double) (e.ticks - origin)) * us_per_tick << ",";
+            outfile << "\"pid\":1,\"tid\":" << buf->tid;
+            outfile << ((e.phase == 'i') ? ",\"s\":\"t\"}" : "}");
+            first_event = false;
+        }
+    }
+    outfile << "\n]}\n";
+}
+
+/**
+ * @brief Trace scope
+ *
+ * Record a begin event at its construction and an end event at its destruction.
+ */
+struct trace_scope {
+    const char * name; ///< Name of the traced scope
+
+    /** @brief Constructor */
+    explicit trace_scope(const char * _name) : name(_name) {
+        local_trace_buffer().record(name,'B');
+    }
+
+    /** @brief Destructor */
+    ~trace_scope() {
+        local_trace_buffer().record(name,'E');
+    }
+};
+
+/**
+ * @brief Trace macros
+ *
+ * Trace the enclosing scope or an instant event. Compiled out unless 'UCT_TRACE' is defined
+ * (see the 'TRACE' variable of the Makefile).
+ */
+#ifdef UCT_TRACE
+#define TRACE_SCOPE(name) trace_scope PROFILE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_INSTANT(name) local_trace_buffer().record(name,'i')
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_INSTANT(name)
+#endif
+
+#endif // TRACE_HPP_
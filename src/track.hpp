@@ -1,6 +1,9 @@
 #ifndef TRACK_HPP_
 #define TRACK_HPP_
 
+#include <chrono>
+#include <thread>
+
 /**
  * @brief Track class
  *
@@ -11,6 +14,7 @@ struct track {
     double stddev; ///< Noise standard deviation
     double failure_probability; ///< Probability with chich the oposite action effect is applied (randomness of the transition function)
     unsigned time; ///< Time
+    double step_duration_ms; ///< Simulated duration of a transition in milliseconds
 
     /** @brief constructor */
     track(
@@ -22,6 +26,7 @@ struct track {
         failure_probability(_failure_prob)
     {
         time = 0;
+        step_duration_ms = 0.;
     }
 
     /**
@@ -49,6 +54,9 @@ struct track {
             action_effect *= (-1.);
         }
         ++time;
+        if(step_duration_ms > 0.) { // the action takes time to execute
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(step_duration_ms));
+        }
         return s + action_effect + normal_double(0.,stddev);
     }
 
@@ -67,4 +75,42 @@ struct track {
     }
 };
 
+/**
+ * @brief Discrete track class
+ *
+ * Noise-free specialization of the track (null 'stddev'), matching 'discrete_model': the
+ * states are integers if the initial state is, no noise is sampled and the states are
+ * compared exactly.
+ */
+struct discrete_track : track {
+    /** @brief constructor */
+    discrete_track(double _track_length, double _failure_prob) :
+        track(_track_length,0.,_failure_prob)
+    {}
+
+    /** @brief Is terminal, see 'track::is_terminal' */
+    bool is_terminal(const double &s) {
+        return !(std::fabs(s) < track_length);
+    }
+
+    /** @brief Transition method, see 'track::transition' */
+    double transition(double s, int a) {
+        double action_effect = (double) a;
+        if(failure_probability > 0. && uniform_double(0.,1.) < failure_probability) {
+            action_effect *= (-1.);
+        }
+        ++time;
+        if(step_duration_ms > 0.) { // the action takes time to execute
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(step_duration_ms));
+        }
+        return s + action_effect;
+    }
+
+    /** @brief Reward method, see 'track::reward' */
+    double reward(double s, int a, double s_p) {
+        (void) a; (void) s_p; //default
+        return (std::fabs(s) < track_length) ? 0. : 1.;
+    }
+};
+
 #endif // TRACK_HPP_
@@ -3,6 +3,61 @@
 
 constexpr double COMPARISON_THRESHOLD = 1e-8;
 
+/**
+ * @brief Random engine
+ *
+ * Random engine of the calling thread, seeded with a random device unless
+ * 'set_random_seed' is called.
+ * @return Return a reference to the engine of the thread.
+ */
+std::mt19937_64 & random_engine() {
+    static thread_local std::mt19937_64 engine(std::random_device{}());
+    return engine;
+}
+
+/**
+ * @brief Set random seed
+ *
+ * Seed the random engine of the calling thread (and the C random generator), so that the
+ * simulations are reproducible.
+ * @param {unsigned long long} seed; the seed
+ */
+void set_random_seed(unsigned long long seed) {
+    random_engine().seed(seed);
+    srand((unsigned) seed);
+}
+
+/**
+ * @brief Mix seed
+ *
+ * Derive a seed from a base seed and an indice (splitmix64 finalizer), so that the derived
+ * seeds of consecutive indices are uncorrelated.
+ * @param {unsigned long long} seed; the base seed
+ * @param {unsigned long long} indice; the indice
+ * @return Return the derived seed, never 0.
+ */
+unsigned long long mix_seed(unsigned long long seed, unsigned long long indice) {
+    unsigned long long z = seed + 0x9e3779b97f4a7c15ULL * (indice + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (z ^ (z >> 31)) | 1ULL;
+}
+
+/**
+ * @brief String hash
+ *
+ * FNV-1a hash of a string, stable across compilers and runs unlike 'std::hash'.
+ * @param {const std::string &} str; the hashed string
+ * @return Return the hash.
+ */
+unsigned long long string_hash(const std::string &str) {
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    for(auto c : str) {
+        h = (h ^ (unsigned char) c) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
 /**
  * @brief Print
  *
@@ -89,28 +144,27 @@ double sign(T x) {
  */
 template <class T>
 inline void shuffle(std::vector<T> &v) {
-    std::random_shuffle(v.begin(), v.end());
+    std::shuffle(v.begin(), v.end(), random_engine());
 }
 
 /**
  * @brief Random indice
  *
- * Pick a random indice of the input vector. You should initialize a random seed when
- * executing your program. Template method.
+ * Pick a random indice of the input vector. Template method.
  * @param {const std::vector<T> &} v; input vector
  * @return Return a random indice.
  */
 template <class T>
 inline unsigned rand_indice(const std::vector<T> &v) {
     assert(v.size() != 0);
-    return rand() % v.size();
+    std::uniform_int_distribution<unsigned> distribution(0,v.size()-1);
+    return distribution(random_engine());
 }
 
 /**
  * @brief Random element
  *
- * Pick a random element of the input vector. You should initialize a random seed when
- * executing your program. Template method.
+ * Pick a random element of the input vector. Template method.
  * @param {const std::vector<T> &} v; input vector
  * @return Return a random element.
  */
@@ -119,22 +173,34 @@ inline T rand_element(const std::vector<T> &v) {
     return v.at(rand_indice(v));
 }
 
+/**
+ * @brief Uniform tie break
+ *
+ * Reservoir sampling among the tied elements without allocation: the k-th tied element
+ * replaces the selected one with probability 1/k.
+ * @param {unsigned} nb_ties; number of tied elements met so far, including the current one
+ * @return Return true if the current tied element should be selected.
+ */
+inline bool uniform_tie_break(unsigned nb_ties) {
+    return nb_ties == 1 || std::uniform_int_distribution<unsigned>(0,nb_ties-1)(random_engine()) == 0;
+}
+
 /**
  * @brief Argmax
  *
- * Get the indice of the maximum element in the input vector, ties are broken arbitrarily.
- * Template method.
+ * Get the indice of the maximum element in the input vector, ties are broken uniformly at
+ * random. Does not allocate. Template method.
  * @param {const std::vector<T> &} v; input vector
  * @return Return the indice of the maximum element in the input vector.
  */
 template <class T>
 inline unsigned argmax(const std::vector<T> &v) {
     auto maxval = *std::max_element(v.begin(),v.end());
-    std::vector<unsigned> up_ind;
+    unsigned ind = 0, nb_ties = 0;
     for (unsigned j=0; j<v.size(); ++j) {
-        if(!is_less_than(v[j],maxval)) {up_ind.push_back(j);}
+        if(!is_less_than(v[j],maxval) && uniform_tie_break(++nb_ties)) {ind = j;}
     }
-    return rand_element(up_ind);
+    return ind;
 }
 
 /**
@@ -145,11 +211,11 @@ inline unsigned argmax(const std::vector<T> &v) {
 template <class T>
 inline unsigned argmin(const std::vector<T> &v) {
     auto minval = *std::min_element(v.begin(),v.end());
-    std::vector<unsigned> lo_ind;
+    unsigned ind = 0, nb_ties = 0;
     for (unsigned j=0; j<v.size(); ++j) {
-        if(!is_greater_than(v[j],minval)) {lo_ind.push_back(j);}
+        if(!is_greater_than(v[j],minval) && uniform_tie_break(++nb_ties)) {ind = j;}
     }
-    return rand_element(lo_ind);
+    return ind;
 }
 
 /**
@@ -159,10 +225,8 @@ inline unsigned argmin(const std::vector<T> &v) {
  * @return Return the sample
  */
 int uniform_integer(int int_min, int int_max) {
-    std::random_device rd;
-    std::default_random_engine generator(rd());
     std::uniform_int_distribution<int> distribution(int_min,int_max);
-    return distribution(generator);
+    return distribution(random_engine());
 }
 
 /**
@@ -172,10 +236,8 @@ int uniform_integer(int int_min, int int_max) {
  * @return Return the sample
  */
 double uniform_double(double double_min, double double_max) {
-    std::random_device rd;
-    std::default_random_engine generator(rd());
     std::uniform_real_distribution<double> distribution(double_min,double_max);
-    return distribution(generator);
+    return distribution(random_engine());
 }
 
 /**
@@ -185,10 +247,8 @@ double uniform_double(double double_min, double double_max) {
  * @return Return the sample
  */
 double normal_double(double mean, double stddev) {
-    std::random_device rd;
-    std::default_random_engine generator(rd());
     std::normal_distribution<double> distribution(mean,stddev);
-    return distribution(generator);
+    return distribution(random_engine());
 }
 
 #endif // UTILS_HPP_
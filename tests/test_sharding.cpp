@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <utils.hpp>
+#include <sharding.hpp>
+
+/**
+ * @brief Main function of the sharding test
+ *
+ * Fork workers from a parent whose random engine is seeded, as the sweeps do, and fail if
+ * two workers draw the same random stream (hence would save identical rows).
+ */
+int main() {
+    const unsigned nb_workers = 4;
+    const unsigned nb_draws = 8;
+    int status = 0;
+    for(unsigned trial=0; trial<2; ++trial) {
+        set_random_seed(trial + 1); // state inherited by every worker
+        shared_results results(nb_workers,nb_draws);
+        unsigned nb_failures = fork_workers(nb_workers,[&](unsigned w) {
+            std::vector<double> row(nb_draws);
+            for(auto &x : row) {
+                x = uniform_double(0.,1.);
+            }
+            results.store(w,row);
+        });
+        if(nb_failures > 0) {
+            std::printf("trial %u: %u worker(s) failed\n",trial,nb_failures);
+            status = 1;
+            continue;
+        }
+        for(unsigned w1=0; w1<nb_workers; ++w1) {
+            for(unsigned w2=w1+1; w2<nb_workers; ++w2) {
+                if(results.load(w1,nb_draws) == results.load(w2,nb_draws)) {
+                    std::printf("trial %u: workers %u and %u drew the same stream\n",trial,w1,w2);
+                    status = 1;
+                }
+            }
+        }
+    }
+    std::printf(status == 0 ? "OK\n" : "FAILED\n");
+    return status;
+}